@@ -0,0 +1,328 @@
+/** @file CompactGraph.h
+ *  @brief Contains the definition of the CompactGraph class.
+ *
+ *  This file defines a snapshot of a Graph stored in compressed sparse row form:
+ *  vertices are numbered 0..n-1 and the outgoing edges of each vertex are stored contiguously,
+ *  with their driving and walking weights in separate arrays. Searches over the snapshot keep
+ *  their labels outside the graph, so several of them can run on the same snapshot at once.
+ */
+
+#ifndef COMPACTGRAPH_H
+#define COMPACTGRAPH_H
+
+#include <vector>
+#include <unordered_map>
+#include "Graph.h"
+
+
+/**
+ * @class CompactGraph
+ * @brief Compressed sparse row copy of a Graph.
+ *
+ * The edges of vertex `v` are the positions `[getFirstEdge(v), getFirstEdge(v+1))` of the edge arrays,
+ * in the same order as in `Vertex::getAdj()`.
+ *
+ * @tparam T The type of the data stored in the vertex (e.g., Location).
+ */
+template <class T>
+class CompactGraph {
+public:
+
+    /**
+     * @brief Builds the snapshot of a graph.
+     * @param g The graph to copy.
+     */
+    explicit CompactGraph(const Graph<T> &g);
+
+    /**
+     * @brief Builds the snapshot of a graph, numbering its vertices in another order.
+     * @param g The graph to copy.
+     * @param order The position in `g.getVertexSet()` of the vertex numbered `i`, for each `i` (a permutation).
+     */
+    CompactGraph(const Graph<T> &g, const std::vector<int> &order);
+
+    /**
+     * @brief Gets the number of vertices.
+     * @return The number of vertices.
+     */
+    int getNumVertex() const;
+
+    /**
+     * @brief Gets the number of (directed) edges.
+     * @return The number of edges.
+     */
+    int getNumEdges() const;
+
+    /**
+     * @brief Finds the index of the vertex of a location.
+     * @param id The ID of the location.
+     * @return The index of the vertex, or -1 if not found.
+     */
+    int findIndex(int id) const;
+
+    /**
+     * @brief Gets the location ID of a vertex.
+     * @param v The index of the vertex.
+     * @return The ID of the location.
+     */
+    int getId(int v) const;
+
+    /**
+     * @brief Gets the data of a vertex.
+     * @param v The index of the vertex.
+     * @return The data stored in the vertex.
+     */
+    const T &getInfo(int v) const;
+
+    /**
+     * @brief Gets the position of the first outgoing edge of a vertex.
+     * @param v The index of the vertex (or getNumVertex() for the end of the last vertex).
+     * @return The position of the edge in the edge arrays.
+     */
+    int getFirstEdge(int v) const;
+
+    /**
+     * @brief Gets the destination of an edge.
+     * @param e The position of the edge.
+     * @return The index of the destination vertex.
+     */
+    int getTarget(int e) const;
+
+    /**
+     * @brief Gets the origin of an edge.
+     * @param e The position of the edge.
+     * @return The index of the origin vertex.
+     */
+    int getOrigin(int e) const;
+
+    /**
+     * @brief Gets the position of the first incoming edge of a vertex in the incoming list.
+     * @param v The index of the vertex (or getNumVertex() for the end of the last vertex).
+     * @return The position in the incoming list, to be used with `getIncoming`.
+     */
+    int getFirstIncoming(int v) const;
+
+    /**
+     * @brief Gets an edge of the incoming list.
+     * @param i The position in the incoming list.
+     * @return The position of the edge in the edge arrays.
+     */
+    int getIncoming(int i) const;
+
+    /**
+     * @brief Finds the first edge between two vertices.
+     * @param u The index of the origin vertex.
+     * @param v The index of the destination vertex.
+     * @return The position of the edge, or -1 if there is none.
+     */
+    int findEdge(int u, int v) const;
+
+    /**
+     * @brief Gets the weight of an edge.
+     * @param e The position of the edge.
+     * @param mode The mode of transportation (true for driving, false for walking).
+     * @return The driving or walking time of the edge.
+     */
+    double getWeight(int e, bool mode) const;
+
+    /**
+     * @brief Gets the destinations of all edges, indexed by edge position.
+     * @return The array of destinations.
+     */
+    const std::vector<int> &getTargets() const;
+
+    /**
+     * @brief Gets the weights of all edges for one mode, indexed by edge position.
+     * @param mode The mode of transportation (true for driving, false for walking).
+     * @return The array of driving or walking times.
+     */
+    const std::vector<double> &getWeights(bool mode) const;
+
+    /**
+     * @brief Gets the version of the graph this snapshot was built from.
+     * @return The version of the source graph.
+     */
+    unsigned long getVersion() const;
+
+    /**
+     * @brief Changes the weight of an edge.
+     *
+     * Only meant for keeping the snapshot in sync with its graph (see LiveMap).
+     *
+     * @param e The position of the edge.
+     * @param mode The mode of transportation (true for driving, false for walking).
+     * @param w The new weight.
+     */
+    void setWeight(int e, bool mode, double w);
+
+    /**
+     * @brief Sets the version of the graph this snapshot corresponds to.
+     * @param v The version of the graph.
+     */
+    void setVersion(unsigned long v);
+
+    /**
+     * @brief Computes the number of bytes used by the snapshot.
+     * @return The number of bytes used, counting the capacity of every array.
+     */
+    size_t getMemoryUsage() const;
+
+protected:
+    std::vector<T> info;                    ///< Data of each vertex
+    std::unordered_map<int, int> index;     ///< Vertex index of each location ID
+    std::vector<int> offsets;               ///< First edge of each vertex (size n+1)
+    std::vector<int> targets;               ///< Destination of each edge
+    std::vector<int> origins;               ///< Origin of each edge
+    std::vector<int> inOffsets;             ///< First incoming edge of each vertex in inEdges (size n+1)
+    std::vector<int> inEdges;               ///< Incoming edges, grouped by destination
+    std::vector<double> driving;            ///< Driving time of each edge
+    std::vector<double> walking;            ///< Walking time of each edge
+    unsigned long version;                  ///< Version of the source graph
+};
+
+
+
+
+template <class T>
+CompactGraph<T>::CompactGraph(const Graph<T> &g) : CompactGraph(g, std::vector<int>()) {}
+
+template <class T>
+CompactGraph<T>::CompactGraph(const Graph<T> &g, const std::vector<int> &order) : version(g.getVersion()) {
+    std::vector<const Vertex<T> *> vertices;
+    vertices.reserve(g.getVertexSet().size());
+    if (order.empty()) vertices.assign(g.getVertexSet().begin(), g.getVertexSet().end());
+    for (int i : order) vertices.push_back(g.getVertexSet()[i]);
+
+    std::unordered_map<const Vertex<T> *, int> position;
+    info.reserve(vertices.size());
+    for (auto v : vertices) {
+        position[v] = info.size();
+        index[v->getInfo().getId()] = info.size();
+        info.push_back(v->getInfo());
+    }
+
+    offsets.reserve(vertices.size() + 1);
+    offsets.push_back(0);
+    for (auto v : vertices) {
+        for (auto e : v->getAdj()) {
+            origins.push_back(offsets.size() - 1);
+            targets.push_back(position[e->getDest()]);
+            driving.push_back(e->getDriving());
+            walking.push_back(e->getWalking());
+        }
+        offsets.push_back(targets.size());
+    }
+
+    // incoming edges, by counting sort on the destination
+    inOffsets.assign(vertices.size() + 1, 0);
+    for (int t : targets) inOffsets[t + 1]++;
+    for (size_t v = 0; v < vertices.size(); v++) inOffsets[v + 1] += inOffsets[v];
+
+    inEdges.resize(targets.size());
+    std::vector<int> fill(inOffsets.begin(), inOffsets.end() - 1);
+    for (size_t e = 0; e < targets.size(); e++) inEdges[fill[targets[e]]++] = e;
+}
+
+template <class T>
+int CompactGraph<T>::getNumVertex() const {
+    return info.size();
+}
+
+template <class T>
+int CompactGraph<T>::getNumEdges() const {
+    return targets.size();
+}
+
+template <class T>
+int CompactGraph<T>::findIndex(int id) const {
+    auto it = index.find(id);
+    return it == index.end() ? -1 : it->second;
+}
+
+template <class T>
+int CompactGraph<T>::getId(int v) const {
+    return info[v].getId();
+}
+
+template <class T>
+const T &CompactGraph<T>::getInfo(int v) const {
+    return info[v];
+}
+
+template <class T>
+int CompactGraph<T>::getFirstEdge(int v) const {
+    return offsets[v];
+}
+
+template <class T>
+int CompactGraph<T>::getTarget(int e) const {
+    return targets[e];
+}
+
+template <class T>
+int CompactGraph<T>::getOrigin(int e) const {
+    return origins[e];
+}
+
+template <class T>
+int CompactGraph<T>::getFirstIncoming(int v) const {
+    return inOffsets[v];
+}
+
+template <class T>
+int CompactGraph<T>::getIncoming(int i) const {
+    return inEdges[i];
+}
+
+template <class T>
+int CompactGraph<T>::findEdge(int u, int v) const {
+    for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+        if (targets[e] == v) return e;
+    }
+    return -1;
+}
+
+template <class T>
+double CompactGraph<T>::getWeight(int e, bool mode) const {
+    return mode ? driving[e] : walking[e];
+}
+
+template <class T>
+const std::vector<int> &CompactGraph<T>::getTargets() const {
+    return targets;
+}
+
+template <class T>
+const std::vector<double> &CompactGraph<T>::getWeights(bool mode) const {
+    return mode ? driving : walking;
+}
+
+template <class T>
+unsigned long CompactGraph<T>::getVersion() const {
+    return version;
+}
+
+template <class T>
+void CompactGraph<T>::setWeight(int e, bool mode, double w) {
+    if (mode) driving[e] = w;
+    else walking[e] = w;
+}
+
+template <class T>
+void CompactGraph<T>::setVersion(unsigned long v) {
+    version = v;
+}
+
+
+template <class T>
+size_t CompactGraph<T>::getMemoryUsage() const {
+    size_t bytes = sizeof(CompactGraph<T>) + info.capacity() * sizeof(T);
+    bytes += (offsets.capacity() + targets.capacity() + origins.capacity() + inOffsets.capacity() + inEdges.capacity()) * sizeof(int);
+    bytes += (driving.capacity() + walking.capacity()) * sizeof(double);
+    // nodes of the hash table, each with a next pointer, and its bucket array
+    bytes += index.size() * (sizeof(std::pair<const int, int>) + sizeof(void *)) + index.bucket_count() * sizeof(void *);
+    return bytes;
+}
+
+
+#endif
@@ -44,13 +44,13 @@ class Distance {
          * @brief Gets the source location.
          * @return The source location.
          */
-        Location getSource() const;
+        const Location &getSource() const;
     
         /**
          * @brief Gets the destination location.
          * @return The destination location.
          */
-        Location getDestination() const; 
+        const Location &getDestination() const; 
     
         /**
          * @brief Gets the driving distance between the locations.
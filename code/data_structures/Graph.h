@@ -19,7 +19,9 @@
 #include <limits>
 #include <algorithm>
 #include <utility>
+#include <atomic>
 #include "MutablePriorityQueue.h"
+#include "../processors/trace.h"
 
 template <class T>
 class Edge;
@@ -31,6 +33,16 @@ class Edge;
 #define INF std::numeric_limits<int>::max()
 
 
+/**
+ * @brief Returns a new graph version, unique across all graphs of the program.
+ * @return The next version number.
+ */
+inline unsigned long nextGraphVersion() {
+    static std::atomic<unsigned long> counter{0};
+    return ++counter;
+}
+
+
 
 /************************* Vertex  **************************/
 
@@ -62,13 +74,13 @@ public:
      * @brief Gets the data (info) of the vertex.
      * @return The data stored in this vertex.
      */
-    T getInfo() const;
+    const T &getInfo() const;
 
     /**
      * @brief Gets the list of outgoing edges from this vertex.
      * @return A vector of pointers to outgoing edges.
      */
-    std::vector<Edge<T> *> getAdj() const;
+    const std::vector<Edge<T> *> &getAdj() const;
 
     /**
      * @brief Checks if the vertex has been visited.
@@ -92,7 +104,7 @@ public:
      * @brief Gets the list of incoming edges to this vertex.
      * @return A vector of pointers to incoming edges.
      */
-    std::vector<Edge<T> *> getIncoming() const;
+    const std::vector<Edge<T> *> &getIncoming() const;
 
     /**
      * @brief Sets the data (info) of the vertex.
@@ -133,7 +145,7 @@ public:
      * @param in The data (info) of the destination vertex.
      * @return True if the edge was removed.
      */
-    bool removeEdge(T in);
+    bool removeEdge(const T &in);
 
     /**
      * @brief Removes all outgoing edges from this vertex.
@@ -348,11 +360,50 @@ public:
      * @brief Gets the set of vertices in the graph.
      * @return A vector of pointers to all vertices in the graph.
      */
-    std::vector<Vertex<T> *> getVertexSet() const;
+    const std::vector<Vertex<T> *> &getVertexSet() const;
+
+    /**
+     * @brief Changes the order of the vertices in the vertex set.
+     *
+     * Only the positions change: the vertices, their data and their edges stay the same.
+     * Snapshots of the map (see CompactGraph) number their vertices in this order.
+     *
+     * @param order The current position of the vertex to place at each position (a permutation).
+     */
+    void reorderVertices(const std::vector<int> &order);
+
+    /**
+     * @brief Gets the version of the graph.
+     *
+     * The version changes every time the graph is modified, and no two graphs share a version,
+     * so it can be used to detect stale results computed from an older state of the graph.
+     *
+     * @return The current version.
+     */
+    unsigned long getVersion() const;
+
+    /**
+     * @brief Marks the graph as modified.
+     *
+     * Must be called after changing edge weights directly through `Edge::setDriving` or `Edge::setWalking`.
+     */
+    void touch();
+
+    /**
+     * @brief Computes the number of bytes used by the graph.
+     *
+     * Counts the graph, its vertices and edges and the capacity of their pointer vectors. 
+     * The interned names and codes of the locations are shared by every graph and aren't counted 
+     * (see Location::getInternedBytes).
+     *
+     * @return The number of bytes used.
+     */
+    size_t getMemoryUsage() const;
 
 
 protected:
     std::vector<Vertex<T> *> vertexSet;    ///< vertex set
+    unsigned long version = nextGraphVersion(); ///< Changes on every modification of the graph
 
     /**
      * @brief Finds the index of a vertex by its data.
@@ -402,7 +453,7 @@ Edge<T> * Vertex<T>::addEdge(Vertex<T> *dest, double d, double w) {
  * Returns true if successful, and false if such edge does not exist.
  */
 template <class T>
-bool Vertex<T>::removeEdge(T in) {
+bool Vertex<T>::removeEdge(const T &in) {
     bool removedEdge = false;
     auto it = adj.begin();
     while (it != adj.end()) {
@@ -439,12 +490,12 @@ bool Vertex<T>::operator<(Vertex<T> & vertex) const {
 }
 
 template <class T>
-T Vertex<T>::getInfo() const {
+const T &Vertex<T>::getInfo() const {
     return this->info;
 }
 
 template <class T>
-std::vector<Edge<T>*> Vertex<T>::getAdj() const {
+const std::vector<Edge<T>*> &Vertex<T>::getAdj() const {
     return this->adj;
 }
 
@@ -464,7 +515,7 @@ Edge<T> *Vertex<T>::getPath() const {
 }
 
 template <class T>
-std::vector<Edge<T> *> Vertex<T>::getIncoming() const {
+const std::vector<Edge<T> *> &Vertex<T>::getIncoming() const {
     return this->incoming;
 }
 
@@ -565,10 +616,29 @@ int Graph<T>::getNumVertex() const {
 }
 
 template <class T>
-std::vector<Vertex<T> *> Graph<T>::getVertexSet() const {
+const std::vector<Vertex<T> *> &Graph<T>::getVertexSet() const {
     return vertexSet;
 }
 
+template <class T>
+void Graph<T>::reorderVertices(const std::vector<int> &order) {
+    std::vector<Vertex<T> *> reordered;
+    reordered.reserve(vertexSet.size());
+    for (int i : order) reordered.push_back(vertexSet[i]);
+    vertexSet.swap(reordered);
+    touch();
+}
+
+template <class T>
+unsigned long Graph<T>::getVersion() const {
+    return version;
+}
+
+template <class T>
+void Graph<T>::touch() {
+    version = nextGraphVersion();
+}
+
 /*
  * Auxiliary function to find a vertex with a given content.
  */
@@ -585,8 +655,7 @@ Vertex<T> * Graph<T>::findVertex(const T &in) const {
 template <class T>
 Vertex<T> * Graph<T>::findLocationId(const int &id) {
     for (auto v : vertexSet) {
-        auto t = v->getInfo();
-        if (t.getId() == id) return v;
+        if (v->getInfo().getId() == id) return v;
     }
     return nullptr;
 }
@@ -611,6 +680,7 @@ bool Graph<T>::addVertex(const T &in) {
     if (findVertex(in) != nullptr)
         return false;
     vertexSet.push_back(new Vertex<T>(in));
+    touch();
     return true;
 }
 
@@ -630,6 +700,7 @@ bool Graph<T>::removeVertex(const T &in) {
             }
             vertexSet.erase(it);
             delete v;
+            touch();
             return true;
         }
     }
@@ -648,6 +719,7 @@ bool Graph<T>::addEdge(const T &sourc, const T &dest, double d, double w) {
     if (v1 == nullptr || v2 == nullptr)
         return false;
     v1->addEdge(v2, d, w);
+    touch();
     return true;
 }
 
@@ -662,6 +734,7 @@ bool Graph<T>::removeEdge(const T &sourc, const T &dest) {
     if (srcVertex == nullptr) {
         return false;
     }
+    touch();
     return srcVertex->removeEdge(dest);
 }
 
@@ -675,17 +748,36 @@ bool Graph<T>::addBidirectionalEdge(const T &sourc, const T &dest, double d, dou
     auto e2 = v2->addEdge(v1, d, w);
     e1->setReverse(e2);
     e2->setReverse(e1);
+    touch();
     return true;
 }
 
 
 template <class T>
-Graph<T>::~Graph() {}
+Graph<T>::~Graph() {
+    // every edge is owned by its origin
+    for (auto v : vertexSet) {
+        for (auto e : v->getAdj()) delete e;
+        delete v;
+    }
+}
+
+template <class T>
+size_t Graph<T>::getMemoryUsage() const {
+    size_t bytes = sizeof(Graph<T>) + vertexSet.capacity() * sizeof(Vertex<T> *);
+    for (auto v : vertexSet) {
+        bytes += sizeof(Vertex<T>);
+        bytes += (v->getAdj().capacity() + v->getIncoming().capacity()) * sizeof(Edge<T> *);
+        bytes += v->getAdj().size() * sizeof(Edge<T>);
+    }
+    return bytes;
+}
 
 
 
 template<class T>
 void Graph<T>::avoidVertices(std::vector<int> vertices) {
+    TRACE_SCOPE("avoidVertices", "graph");
     if (!vertices.empty()) {
         for (auto id : vertices) {
             Vertex<T>* loc = findLocationId(id);
@@ -697,6 +789,7 @@ void Graph<T>::avoidVertices(std::vector<int> vertices) {
 
 template<class T>
 void Graph<T>::avoidEdges(std::vector<std::pair<int,int>> edges) {
+    TRACE_SCOPE("avoidEdges", "graph");
     if (!edges.empty()) {
         for (auto p : edges) {
             int sId = p.first;
@@ -707,12 +800,14 @@ void Graph<T>::avoidEdges(std::vector<std::pair<int,int>> edges) {
     
             if(source!=nullptr && dest!=nullptr) source->removeEdge(dest->getInfo());
         }
+        touch();
     }
 }
 
 
 template <class T>
 Graph<T>* copyGraph(Graph<T>* g) {
+    TRACE_SCOPE("copyGraph", "graph");
     Graph<T>* gC = new Graph<T>();
 
     // we add the vertices
@@ -1,12 +1,38 @@
 #include "Location.h"
+#include "../processors/memory.h"
 using namespace std;
 
-Location::Location() : location(""), id(0), code(""), parking(false) {} 
-Location::Location(string l, int id, string code, bool p) : location(l), id(id), code(code), parking(p) {}
+static unordered_set<string> &stringTable() {
+    static unordered_set<string> table;
+    return table;
+}
 
-string Location::getLocation() const { return location; }
+static mutex tableMutex;
+
+const string *Location::intern(const string &s) {
+    lock_guard<mutex> lock(tableMutex);
+    return &*stringTable().insert(s).first;
+}
+
+size_t Location::getInternedBytes() {
+    lock_guard<mutex> lock(tableMutex);
+    const auto &table = stringTable();
+
+    // nodes with a next pointer and the cached hash, and the bucket array
+    size_t bytes = table.bucket_count() * sizeof(void *);
+    for (auto &s : table) bytes += sizeof(string) + 2 * sizeof(void *) + stringHeapBytes(s);
+    return bytes;
+}
+
+Location::Location() : id(0), parking(false) {
+    static const string *empty = intern("");
+    location = code = empty;
+}
+Location::Location(string l, int id, string code, bool p) : location(intern(l)), code(intern(code)), id(id), parking(p) {}
+
+const string &Location::getLocation() const { return *location; }
 int Location::getId() const { return id; }
-string Location::getCode() const { return code; }
+const string &Location::getCode() const { return *code; }
 bool Location::hasParking() const { return parking; }
 
 bool Location::operator==(const Location &other) const {
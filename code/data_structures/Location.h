@@ -4,6 +4,10 @@
  *  This file defines the Location class, which represents a location with details 
  *  such as the name, unique ID, code, and parking availability. The class provides 
  *  methods to access and compare these details.
+ *
+ *  Every vertex of the graph holds a Location, so the class only keeps the ID, the parking flag 
+ *  and pointers to its name and code, which are interned once in a shared string table. This keeps 
+ *  the memory per vertex small, and copying a Location, where one is still copied, cheap.
  */
 
 #ifndef LOCATION_H
@@ -11,6 +15,8 @@
 
 
 #include <string>
+#include <unordered_set>
+#include <mutex>
 using namespace std;
 
 /**
@@ -41,7 +47,7 @@ class Location {
          * @brief Gets the name of the location.
          * @return The name of the location as a string.
          */
-        string getLocation() const;
+        const string &getLocation() const;
 
         /**
          * @brief Gets the unique ID of the location.
@@ -53,7 +59,7 @@ class Location {
          * @brief Gets the code associated with the location.
          * @return The code of the location as a string.
          */
-        string getCode() const;
+        const string &getCode() const;
 
         /**
          * @brief Checks if the location has parking available.
@@ -69,11 +75,27 @@ class Location {
          */
         bool operator==(const Location &other) const;
 
+        /**
+         * @brief Computes the number of bytes used by the shared string table.
+         * @return The number of bytes used by the interned names and codes.
+         */
+        static size_t getInternedBytes();
+
     private:
-        string location; ///< The name of the location.
-        int id;          ///< The unique identifier for the location.
-        string code;     ///< The code associated with the location.
-        bool parking;    ///< Indicates if the location has parking available.
+        const string *location; ///< The name of the location (interned).
+        const string *code;     ///< The code associated with the location (interned).
+        int id;                 ///< The unique identifier for the location.
+        bool parking;           ///< Indicates if the location has parking available.
+
+        /**
+         * @brief Returns the shared copy of a string, adding it to the string table if needed.
+         *
+         * Equal strings always map to the same pointer, so codes can be compared by address.
+         *
+         * @param s The string to intern.
+         * @return A pointer to the interned string, valid for the lifetime of the program.
+         */
+        static const string *intern(const string &s);
 };
 
 
@@ -35,6 +35,8 @@
  template <class T>
  class MutablePriorityQueue { 
      std::vector<T *> H; ///< The underlying vector storing the heap elements.
+     unsigned long inserts = 0;     ///< Number of calls to `insert`.
+     unsigned long decreases = 0;   ///< Number of calls to `decreaseKey`.
 
      /**
      * @brief Ensures the heap property is maintained when moving an element up the heap.
@@ -104,6 +106,23 @@
      */
      void decreaseKey(T * x);
 
+     /**
+     * @brief Gets the minimum element without extracting it.
+     *
+     * The queue must not be empty.
+     *
+     * @return A pointer to the minimum element in the queue.
+     */
+     T * findMin();
+     /**
+     * @brief Removes an element from the priority queue.
+     *
+     * This method replaces the element with the last one of the heap and moves that one up or down
+     * to restore the heap property. It is needed when the key of an element grows.
+     *
+     * @param x A pointer to the element to be removed, which must be in the queue.
+     */
+     void remove(T * x);
      /**
      * @brief Checks whether the priority queue is empty.
      *
@@ -112,6 +131,20 @@
      * @return `true` if the queue is empty, otherwise `false`.
      */
      bool empty();
+
+     /**
+     * @brief Gets the number of elements inserted so far.
+     *
+     * @return The number of calls to `insert`.
+     */
+     unsigned long getInserts() const;
+
+     /**
+     * @brief Gets the number of keys decreased so far.
+     *
+     * @return The number of calls to `decreaseKey`.
+     */
+     unsigned long getDecreaseKeys() const;
  };
  
  // Index calculations
@@ -141,17 +174,46 @@
      return x;
  }
  
+ template <class T>
+ T* MutablePriorityQueue<T>::findMin() {
+     return H[1];
+ }
+ 
+ template <class T>
+ void MutablePriorityQueue<T>::remove(T *x) {
+     unsigned i = x->queueIndex;
+     auto last = H.back();
+     H.pop_back();
+     x->queueIndex = 0;
+     if (i == H.size()) return;     // x was the last one
+     set(i, last);
+     heapifyUp(i);
+     heapifyDown(last->queueIndex);
+ }
+ 
  template <class T>
  void MutablePriorityQueue<T>::insert(T *x) {
+     inserts++;
      H.push_back(x);
      heapifyUp(H.size()-1);
  }
  
  template <class T>
  void MutablePriorityQueue<T>::decreaseKey(T *x) {
+     decreases++;
      heapifyUp(x->queueIndex);
  }
  
+ template <class T>
+ unsigned long MutablePriorityQueue<T>::getInserts() const {
+     return inserts;
+ }
+ 
+ template <class T>
+ unsigned long MutablePriorityQueue<T>::getDecreaseKeys() const {
+     return decreases;
+ }
+ 
  template <class T>
  void MutablePriorityQueue<T>::heapifyUp(unsigned i) {
      auto x = H[i];
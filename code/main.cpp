@@ -5,12 +5,27 @@
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <cctype>
 #include "processors/loader.h"
 #include "processors/menu.h"
+#include "processors/MapStore.h"
+#include "processors/server.h"
+#include "processors/bench.h"
+#include "processors/writer.h"
+#include "processors/gate.h"
 
 using namespace std;
 
 
+/**
+ * @brief Writes the command line options to the standard error.
+ * @param program The name the program was run with.
+ */
+static void usage(const char *program) {
+    cerr << "Usage: " << program << " [--serve <socket>|- [threads]] [--schedule] [--stats inline|<file>] [--metrics <file>] [--trace <file>] [--format text|jsonl|binary] [--order code|bfs|rcm] [--bench <name> [rounds]]\n";
+}
+
+
 // ===== MAIN FUNCTION =====
 
 
@@ -18,33 +33,115 @@ using namespace std;
  * @file main.cpp
  * @brief Main function of the program.
  *
- * This function serves as the entry point of the program. It loads the necessary data sets,
- * initializes the graph representing the city map, and then presents the user with a menu 
- * to choose the type of route to calculate. The program's execution is then concluded 
- * by deleting the graph object to free allocated memory.
+ * This function serves as the entry point of the program. It loads the necessary data sets
+ * into a MapStore, which builds the graph representing the city map and reloads it whenever 
+ * the data sets are republished, and then presents the user with a menu to choose the type 
+ * of route to calculate.
  *
- * - Loads the locations from the "Locations.csv" file.
- * 
- * - Loads the distances from the "Distances.csv" file.
+ * - Loads the locations from the "Locations.csv" file and the distances from the "Distances.csv" file.
  * 
  * - Initializes the graph that represents the city map.
  * 
+ * - Starts watching the data sets for changes in the background.
+ * 
  * - Starts a menu, calling the `chooseRoute` function to allow the user to select a route, which will call `chooseMode` to select a menu mode.
+ *   With `--serve <socket> [threads]`, serves route requests over a Unix domain socket instead 
+ *   (or over the standard input and output if the socket is "-"), see server.h.
+ *   With `--serve - --schedule`, the whole standard input is read as a batch and its queries are 
+ *   scheduled before they run, see scheduler.h (`--schedule` is rejected without `--serve -`).
+ *   With `--stats inline` or `--stats <file>`, the search counters of every query are written
+ *   after its output or appended to the file as JSON lines, see SearchStats.h.
+ *   With `--metrics <file>`, latency histograms and throughput metrics are written to the file in 
+ *   the Prometheus text format at the end of a batch, on request and when the server stops, see QueryMetrics.h.
+ *   With `--trace <file>`, a Chrome trace-event timeline of the run is written to the file, 
+ *   if tracing was compiled in, see trace.h.
+ *   With `--format text|jsonl|binary`, the results are written as text (the default), JSON lines or 
+ *   binary records, see writer.h.
+ *   With `--order code|bfs|rcm`, the vertices of the map are numbered in that order, see loader.h.
+ *   With `--bench <name> [rounds]`, runs a benchmark on the city map and exits instead, see bench.h.
+ *   With `--bench gate [rounds]`, runs the performance regression gate against data_sets/PerfBaseline.txt
+ *   and exits, and with `--bench gate-update [rounds]` rewrites that baseline, see gate.h.
  * 
- * - Frees the dynamically allocated memory used by the graph object.
+ * - Stops the watcher. The graph is freed by the store once nothing uses it.
  *
- * @return 0 to indicate successful execution of the program.
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments.
+ * @return 0 to indicate successful execution of the program, 1 if the data sets couldn't be loaded.
  */
-int main() {
+int main(int argc, char *argv[]) {
+
+    bool serve = false;
+    bool schedule = false;
+    string path;
+    unsigned threads = 0;
+    string bench;
+    unsigned rounds = 200;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--serve" && i + 1 < argc) {
+            serve = true;
+            path = argv[++i];
+            if (i + 1 < argc && isdigit(argv[i + 1][0])) threads = stoul(argv[++i]);
+        } 
+        else if (arg == "--schedule") {
+            schedule = true;
+        } 
+        else if (arg == "--stats" && i + 1 < argc) {
+            if (!setStatsOutput(argv[++i])) return 1;
+        } 
+        else if (arg == "--metrics" && i + 1 < argc) {
+            setMetricsFile(argv[++i]);
+        } 
+        else if (arg == "--trace" && i + 1 < argc) {
+            if (!startTrace(argv[++i])) return 1;
+        } 
+        else if (arg == "--format" && i + 1 < argc) {
+            if (!setOutputFormat(argv[++i])) return 1;
+        } 
+        else if (arg == "--order" && i + 1 < argc) {
+            if (!setVertexOrder(argv[++i])) return 1;
+        } 
+        else if (arg == "--bench" && i + 1 < argc) {
+            bench = argv[++i];
+            if (i + 1 < argc && isdigit(argv[i + 1][0])) rounds = stoul(argv[++i]);
+        } 
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // only a batch read from the standard input can be scheduled
+    if (schedule && path != "-") {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // when serving over stdout, everything else goes to stderr
+    ostream responses(cout.rdbuf());
+    if (path == "-") cout.rdbuf(cerr.rdbuf());
     
+    const string locationsFile = "../data_sets/Locations.csv", distancesFile = "../data_sets/Distances.csv";
+    if (bench == "gate" || bench == "gate-update") {
+        return runGate(locationsFile, distancesFile, "../data_sets/PerfBaseline.txt", bench == "gate-update", rounds);
+    }
+
     // Load data sets
-    loadLocations("../data_sets/Locations.csv");
-    loadDistances("../data_sets/Distances.csv");
+    MapStore store(locationsFile, distancesFile);
+    if (!store.reload()) return 1;
+
+    if (!bench.empty()) return runBenchmark(store, bench, rounds);
 
-    Graph<Location>* cityMap = initializeGraph();
+    store.watch();
 
-    chooseRoute(cityMap);
+    int status = 0;
+    if (path == "-" && schedule) status = serveBatch(store, cin, responses, threads);
+    else if (path == "-") status = serveStream(store, cin, responses, threads);
+    else if (serve) status = serveSocket(store, path, threads);
+    else chooseRoute(store);
 
-    delete cityMap;
-    return 0;
+    store.stop();
+    cout.rdbuf(responses.rdbuf());
+    return status;
 }
\ No newline at end of file
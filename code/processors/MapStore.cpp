@@ -0,0 +1,120 @@
+#include "MapStore.h"
+
+using namespace std;
+
+
+MapStore::MapStore(const string &locationsFile, const string &distancesFile)
+    : locationsFile(locationsFile), distancesFile(distancesFile) {}
+
+
+MapStore::~MapStore() {
+    stop();
+}
+
+
+pair<MapStore::Stamp, MapStore::Stamp> MapStore::readStamps() const {
+    error_code ec1, ec2;
+    Stamp l = filesystem::last_write_time(locationsFile, ec1);
+    Stamp d = filesystem::last_write_time(distancesFile, ec2);
+    return {ec1 ? Stamp::min() : l, ec2 ? Stamp::min() : d};
+}
+
+
+bool MapStore::reload() {
+    TRACE_SCOPE("reload", "load");
+    lock_guard<mutex> guard(reloadLock);
+
+    // stamps are read first, so a change made while loading triggers another reload
+    pair<Stamp, Stamp> stamps = readStamps();
+
+    LoadMemory memory;
+    Graph<Location> *map = loadCityMap(locationsFile, distancesFile, &memory);
+    if (!map) {
+        cerr << "Couldn't load the city data, keeping the current map.\n";
+        return false;
+    }
+
+    {
+        lock_guard<mutex> memoryGuard(memoryLock);
+        loadMemory = memory;
+    }
+
+    // the parking catchment only depends on the map, so it's computed before any query needs it
+    {
+        LiveMap &live = liveMap(map);
+        shared_lock<shared_mutex> shared(live.getLock());
+        live.getCatchment();
+    }
+
+    // the map is reclaimed by whichever reader releases it last
+    shared_ptr<Graph<Location>> fresh(map, [](Graph<Location> *g) {
+        releaseLiveMap(g);
+        delete g;
+    });
+
+    atomic_store(&current, fresh);
+    generation++;
+
+    // only once published: after a failed load the watcher keeps retrying
+    loadedStamps = stamps;
+    return true;
+}
+
+
+shared_ptr<Graph<Location>> MapStore::acquire() const {
+    return atomic_load(&current);
+}
+
+
+unsigned long MapStore::getGeneration() const {
+    return generation;
+}
+
+
+LoadMemory MapStore::getLoadMemory() const {
+    lock_guard<mutex> guard(memoryLock);
+    return loadMemory;
+}
+
+
+void MapStore::watch(chrono::milliseconds interval) {
+    stop();
+    {
+        lock_guard<mutex> guard(watchLock);
+        stopping = false;
+    }
+    watcher = thread(&MapStore::pollLoop, this, interval);
+}
+
+
+void MapStore::stop() {
+    {
+        lock_guard<mutex> guard(watchLock);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (watcher.joinable()) watcher.join();
+}
+
+
+void MapStore::pollLoop(chrono::milliseconds interval) {
+    pair<Stamp, Stamp> previous = readStamps();
+
+    unique_lock<mutex> guard(watchLock);
+    while (!wakeup.wait_for(guard, interval, [this] { return stopping; })) {
+        guard.unlock();
+
+        pair<Stamp, Stamp> stamps = readStamps();
+        bool changed;
+        {
+            lock_guard<mutex> reloading(reloadLock);
+            changed = stamps != loadedStamps;
+        }
+
+        // only reload files that didn't change since the previous poll
+        if (changed && stamps == previous) reload();
+        previous = stamps;
+
+        guard.lock();
+    }
+}
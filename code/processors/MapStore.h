@@ -0,0 +1,130 @@
+/** @file MapStore.h
+ *  @brief Contains the definition of the MapStore class.
+ *
+ *  This file defines the MapStore class, which owns the current city map and replaces it
+ *  with a freshly loaded one when the data sets are republished, without stopping the
+ *  queries that are using the previous map.
+ */
+
+#ifndef MAPSTORE_H
+#define MAPSTORE_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <filesystem>
+#include <condition_variable>
+
+#include "loader.h"
+#include "../routes/LiveMap.h"
+#include "../data_structures/Graph.h"
+#include "../data_structures/Location.h"
+
+using namespace std;
+
+
+/**
+ * @class MapStore
+ * @brief Holder of the current city map, reloaded read-copy-update style.
+ *
+ * A reload builds the new map from the data sets in the background and then publishes it 
+ * with a single atomic pointer swap. Queries take a reference to the current map with 
+ * `acquire()` and keep using it until they finish, even if a newer map is published in the 
+ * meantime. A map is deleted, together with its LiveMap, when its last reader releases it.
+ *
+ * An optional watcher thread polls the modification times of the data sets and reloads them 
+ * once they have changed and stayed unchanged for a whole polling interval, so a file that is 
+ * still being written isn't loaded. If a reload fails, the current map is kept and the reload is
+ * tried again at the next poll.
+ */
+class MapStore {
+
+    public:
+        /**
+         * @brief Constructor for MapStore. Doesn't load anything yet.
+         * @param locationsFile The name of the CSV file containing location data.
+         * @param distancesFile The name of the CSV file containing distance data.
+         */
+        MapStore(const string &locationsFile, const string &distancesFile);
+
+        /**
+         * @brief Destructor for MapStore. Stops the watcher, if running.
+         */
+        ~MapStore();
+
+        MapStore(const MapStore &) = delete;
+        MapStore &operator=(const MapStore &) = delete;
+
+        /**
+         * @brief Loads the data sets and publishes the new map.
+         * @return True if the map was replaced, false if loading failed and the current map was kept.
+         */
+        bool reload();
+
+        /**
+         * @brief Gets the current map.
+         * 
+         * The map stays valid while the returned pointer (or a copy of it) is alive.
+         * 
+         * @return The current map, or nullptr if nothing was loaded yet.
+         */
+        shared_ptr<Graph<Location>> acquire() const;
+
+        /**
+         * @brief Gets the number of maps published so far.
+         * @return The generation of the current map.
+         */
+        unsigned long getGeneration() const;
+
+        /**
+         * @brief Gets the bytes used by the last successful load of the data sets.
+         * @return The bytes used by the loader containers and the graph.
+         */
+        LoadMemory getLoadMemory() const;
+
+        /**
+         * @brief Starts polling the data sets for changes on a background thread.
+         * @param interval Time between polls.
+         */
+        void watch(chrono::milliseconds interval = chrono::seconds(2));
+
+        /**
+         * @brief Stops the watcher thread, if running.
+         */
+        void stop();
+
+    private:
+        typedef filesystem::file_time_type Stamp;
+
+        string locationsFile;                   ///< Path of the locations data set
+        string distancesFile;                   ///< Path of the distances data set
+        shared_ptr<Graph<Location>> current;    ///< Current map (only accessed atomically)
+        atomic<unsigned long> generation{0};    ///< Number of maps published
+        mutex reloadLock;                       ///< Serializes reloads
+        pair<Stamp, Stamp> loadedStamps;        ///< Modification times of the last files loaded
+        LoadMemory loadMemory;                  ///< Bytes used by the last load
+        mutable mutex memoryLock;               ///< Protects `loadMemory`
+
+        thread watcher;                         ///< Polling thread
+        mutex watchLock;                        ///< Protects `stopping`
+        condition_variable wakeup;              ///< Wakes the watcher up early to stop
+        bool stopping = false;                  ///< Set to stop the watcher
+
+        /**
+         * @brief Gets the modification times of the data sets.
+         * @return The modification times (the minimum value for a missing file).
+         */
+        pair<Stamp, Stamp> readStamps() const;
+
+        /**
+         * @brief Body of the watcher thread.
+         * @param interval Time between polls.
+         */
+        void pollLoop(chrono::milliseconds interval);
+};
+
+
+#endif
@@ -0,0 +1,54 @@
+#include "ThreadPool.h"
+
+#include <iostream>
+
+using namespace std;
+
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; i++) workers.emplace_back(&ThreadPool::work, this);
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto &t : workers) t.join();
+}
+
+
+void ThreadPool::submit(function<void()> task) {
+    {
+        lock_guard<mutex> guard(lock);
+        tasks.push_back(move(task));
+    }
+    ready.notify_one();
+}
+
+
+unsigned ThreadPool::size() const {
+    return workers.size();
+}
+
+
+void ThreadPool::work() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            ready.wait(guard, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;      // stopping, and nothing left to run
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+
+        // a failing task must not take the worker, and the whole process, down with it
+        try {task();}
+        catch (const exception &e) {cerr << "Task failed: " << e.what() << "\n";}
+        catch (...) {cerr << "Task failed.\n";}
+    }
+}
@@ -0,0 +1,71 @@
+/** @file ThreadPool.h
+ *  @brief Contains the definition of the ThreadPool class.
+ *
+ *  This file defines a fixed-size pool of worker threads that run queued tasks in order of
+ *  submission.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+using namespace std;
+
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads consuming a shared queue of tasks.
+ *
+ * Tasks are started in the order they were submitted. Destroying the pool runs the tasks that
+ * are still queued and then joins the workers.
+ */
+class ThreadPool {
+
+    public:
+        /**
+         * @brief Constructor for ThreadPool. Starts the workers.
+         * @param threads Number of workers (0 uses the hardware concurrency).
+         */
+        explicit ThreadPool(unsigned threads = 0);
+
+        /**
+         * @brief Destructor for ThreadPool. Waits for every queued task to finish.
+         */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief Queues a task.
+         * @param task The task to run on one of the workers.
+         */
+        void submit(function<void()> task);
+
+        /**
+         * @brief Gets the number of workers.
+         * @return The number of workers.
+         */
+        unsigned size() const;
+
+    private:
+        vector<thread> workers;             ///< The worker threads
+        deque<function<void()>> tasks;      ///< Tasks waiting for a worker
+        mutex lock;                         ///< Protects `tasks` and `stopping`
+        condition_variable ready;           ///< Signals new tasks or stopping
+        bool stopping = false;              ///< Set when the pool is destroyed
+
+        /**
+         * @brief Body of each worker: runs tasks until the pool is stopped and the queue is empty.
+         */
+        void work();
+};
+
+
+#endif
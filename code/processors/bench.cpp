@@ -0,0 +1,472 @@
+#include "bench.h"
+
+using namespace std;
+
+
+/**
+ * @brief Gets the milliseconds elapsed since a moment.
+ */
+static double millisSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+ * @brief Prints one timed variant of a benchmark.
+ */
+static void printVariant(const string &name, double ms, unsigned rounds, double baseline) {
+    cout << "  " << left << setw(22) << name << right << fixed << setprecision(3) << setw(10) << ms / rounds << " ms/round";
+    if (baseline > 0) cout << setprecision(2) << "  (x" << baseline / ms << ")";
+    cout << "\n";
+}
+
+
+/**
+ * @brief Relaxes every edge of a CompactGraph once, from the distances in `dist`, with a kernel.
+ * @return The sum of the resulting distances.
+ */
+static double kernelPass(const CompactGraph<Location> &g, RelaxKernel kernel, vector<double> &dist, vector<int> &improved) {
+    const int *targets = g.getTargets().data();
+    const double *weights = g.getWeights(true).data();
+
+    for (int v = 0; v < g.getNumVertex(); v++) {
+        double d = dist[v];
+        int count = kernel(targets, weights, g.getFirstEdge(v), g.getFirstEdge(v + 1), d, dist.data(), INF, improved.data());
+        for (int i = 0; i < count; i++) {
+            int e = improved[i];
+            if (d + weights[e] < dist[targets[e]]) dist[targets[e]] = d + weights[e];
+        }
+    }
+
+    double sum = 0;
+    for (double d : dist) sum += d;
+    return sum;
+}
+
+
+static int benchRelax(MapStore &store, unsigned rounds) {
+    shared_ptr<Graph<Location>> cityMap = store.acquire();
+    LiveMap &live = liveMap(cityMap.get());
+    shared_lock<shared_mutex> lock(live.getLock());
+    lock_guard<mutex> labelGuard(live.getLabelLock());
+
+    auto snapshot = live.getSnapshot();
+    const CompactGraph<Location> &g = *snapshot;
+    int n = g.getNumVertex();
+    if (n == 0 || rounds == 0) return 1;
+
+    cout << "Benchmark relax: " << n << " vertices, " << g.getNumEdges() << " edges, " << rounds << " rounds, AVX2 "
+         << (simdRelaxSupported() ? "supported" : "not supported") << "\n";
+
+    mt19937 random(42);
+    uniform_int_distribution<int> pick(0, n - 1);
+    uniform_real_distribution<double> start(0, 1000);
+
+    int maxDegree = 0;
+    for (int v = 0; v < n; v++) maxDegree = max(maxDegree, g.getFirstEdge(v + 1) - g.getFirstEdge(v));
+    vector<int> improved(maxDegree);
+
+    vector<RelaxKernel> kernels = {relaxEdgesScalar};
+#ifdef DA_AVX2_RELAX
+    if (simdRelaxSupported()) kernels.push_back(relaxEdgesAVX2);
+#endif
+
+    bool agree = true;
+
+    // 1. one pass over every edge from random distances, the Graph relaxed in the same vertex and edge order
+    vector<double> base(n);
+    for (double &d : base) d = start(random);
+
+    const auto &vertices = cityMap->getVertexSet();
+    vector<int> position;
+    for (auto v : vertices) position.push_back(g.findIndex(v->getInfo().getId()));
+
+    cout << "Relaxation passes over every edge:\n";
+    double graphSum = 0;
+    auto clock = chrono::steady_clock::now();
+    for (unsigned r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < vertices.size(); i++) vertices[i]->setDist(base[position[i]]);
+        for (auto v : vertices) {
+            for (auto e : v->getAdj()) relax<DrivingMetric>(e);
+        }
+    }
+    double baseline = millisSince(clock);
+    for (auto v : vertices) graphSum += v->getDist();
+    printVariant("Graph relax()", baseline, rounds, 0);
+
+    for (RelaxKernel kernel : kernels) {
+        vector<double> dist;
+        double sum = 0;
+        clock = chrono::steady_clock::now();
+        for (unsigned r = 0; r < rounds; r++) {
+            dist = base;
+            sum = kernelPass(g, kernel, dist, improved);
+        }
+        printVariant(kernel == relaxEdgesScalar ? "scalar kernel" : "avx2 kernel", millisSince(clock), rounds, baseline);
+        if (sum != graphSum) agree = false;
+    }
+
+    // 2. one-to-one searches between random locations
+    vector<pair<int, int>> queries;
+    for (unsigned r = 0; r < rounds; r++) queries.push_back({pick(random), pick(random)});
+
+    cout << "One-to-one searches:\n";
+    vector<double> expected;
+    clock = chrono::steady_clock::now();
+    for (auto [s, t] : queries) {
+        int source = g.getId(s), dest = g.getId(t);
+        if (initDijkstra(cityMap.get())) dijkstra<DrivingMetric>(cityMap.get(), source, dest);
+        expected.push_back(cityMap->findLocationId(dest)->getDist());
+    }
+    baseline = millisSince(clock);
+    printVariant("dijkstra + relax()", baseline, rounds, 0);
+
+    SearchLabels labels;
+    for (RelaxKernel kernel : kernels) {
+        setSimdRelax(kernel != relaxEdgesScalar);
+        clock = chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            SweepOptions options;
+            options.targets = {queries[i].second};
+            sweep(g, queries[i].first, true, labels, options);
+            if (labels.dist[queries[i].second] != expected[i]) agree = false;
+        }
+        printVariant(kernel == relaxEdgesScalar ? "sweep, scalar kernel" : "sweep, avx2 kernel", millisSince(clock), rounds, baseline);
+    }
+
+    // 3. one-to-all searches
+    cout << "One-to-all searches:\n";
+    vector<double> reference;
+    baseline = 0;
+    for (RelaxKernel kernel : kernels) {
+        setSimdRelax(kernel != relaxEdgesScalar);
+        clock = chrono::steady_clock::now();
+        for (auto query : queries) {
+            sweep(g, query.first, true, labels);
+        }
+        double ms = millisSince(clock);
+        printVariant(kernel == relaxEdgesScalar ? "sweep, scalar kernel" : "sweep, avx2 kernel", ms, rounds, baseline);
+        if (baseline == 0) baseline = ms;
+
+        if (reference.empty()) reference = labels.dist;
+        else if (reference != labels.dist) agree = false;
+    }
+    setSimdRelax(true);
+
+    cout << (agree ? "All variants agree.\n" : "Variants disagree!\n");
+    return agree ? 0 : 1;
+}
+
+
+static int benchMulti(MapStore &store, unsigned rounds) {
+    shared_ptr<Graph<Location>> cityMap = store.acquire();
+    LiveMap &live = liveMap(cityMap.get());
+    shared_lock<shared_mutex> lock(live.getLock());
+    lock_guard<mutex> labelGuard(live.getLabelLock());
+
+    auto snapshot = live.getSnapshot();
+    const CompactGraph<Location> &g = *snapshot;
+    int n = g.getNumVertex();
+    if (n == 0 || rounds == 0) return 1;
+
+    const int TARGETS = 16;
+    cout << "Benchmark multi: " << n << " vertices, " << g.getNumEdges() << " edges, " << rounds << " sources x " << TARGETS 
+         << " targets, " << RELAX_LANES << " lanes, AVX2 " << (simdRelaxSupported() ? "supported" : "not supported") << "\n";
+
+    mt19937 random(42);
+    uniform_int_distribution<int> pick(0, n - 1);
+    vector<int> sources, targets;
+    for (unsigned r = 0; r < rounds; r++) sources.push_back(pick(random));
+    for (int t = 0; t < TARGETS; t++) targets.push_back(pick(random));
+
+    SweepOptions options;
+    options.targets = targets;
+
+    bool agree = true;
+    for (bool mode : {true, false}) {
+        cout << (mode ? "Driving matrix:\n" : "Walking matrix:\n");
+
+        // what the graph searches do: one search per pair
+        vector<vector<double>> expected(sources.size(), vector<double>(TARGETS));
+        auto clock = chrono::steady_clock::now();
+        for (size_t i = 0; i < sources.size(); i++) {
+            for (int j = 0; j < TARGETS; j++) {
+                Vertex<Location> *dest = cityMap->findLocationId(g.getId(targets[j]));
+                if (initDijkstra(cityMap.get())) dijkstra(cityMap.get(), g.getId(sources[i]), dest->getInfo().getId(), mode);
+                expected[i][j] = dest->getDist();
+            }
+        }
+        double baseline = millisSince(clock);
+        printVariant("dijkstra per pair", baseline, rounds, 0);
+
+        SearchLabels labels;
+        clock = chrono::steady_clock::now();
+        for (size_t i = 0; i < sources.size(); i++) {
+            sweep(g, sources[i], mode, labels, options);
+            for (int j = 0; j < TARGETS; j++) {
+                if (labels.dist[targets[j]] != expected[i][j]) agree = false;
+            }
+        }
+        printVariant("sweep per source", millisSince(clock), rounds, baseline);
+
+        for (bool simd : {false, true}) {
+            if (simd && !simdRelaxSupported()) continue;
+            setSimdRelax(simd);
+
+            MultiSearchLabels multi;
+            clock = chrono::steady_clock::now();
+            for (size_t b = 0; b < sources.size(); b += RELAX_LANES) {
+                vector<int> batch(sources.begin() + b, sources.begin() + min(sources.size(), b + RELAX_LANES));
+                multiSweep(g, batch, mode, multi, options);
+                for (size_t k = 0; k < batch.size(); k++) {
+                    for (int j = 0; j < TARGETS; j++) {
+                        if (multi.getDist(k, targets[j]) != expected[b + k][j]) agree = false;
+                    }
+                }
+            }
+            printVariant(simd ? "multiSweep, avx2" : "multiSweep, scalar", millisSince(clock), rounds, baseline);
+        }
+        setSimdRelax(true);
+    }
+
+    cout << (agree ? "All variants agree.\n" : "Variants disagree!\n");
+    return agree ? 0 : 1;
+}
+
+
+static int benchDelta(MapStore &store, unsigned rounds) {
+    shared_ptr<Graph<Location>> cityMap = store.acquire();
+    LiveMap &live = liveMap(cityMap.get());
+    shared_lock<shared_mutex> lock(live.getLock());
+
+    auto snapshot = live.getSnapshot();
+    const CompactGraph<Location> &g = *snapshot;
+    int n = g.getNumVertex();
+    if (n == 0 || rounds == 0) return 1;
+
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    cout << "Benchmark delta: " << n << " vertices, " << g.getNumEdges() << " edges, " << rounds << " one-to-all searches, "
+         << cores << " hardware threads\n";
+
+    mt19937 random(42);
+    uniform_int_distribution<int> pick(0, n - 1);
+    vector<int> sources;
+    for (unsigned r = 0; r < rounds; r++) sources.push_back(pick(random));
+
+    bool agree = true;
+    for (bool mode : {true, false}) {
+        cout << (mode ? "Driving:\n" : "Walking:\n");
+
+        // the automatic width must follow the usable edges, not the impassable ones
+        const vector<double> &weights = g.getWeights(mode);
+        double largest = 0;
+        size_t impassable = 0;
+        for (double w : weights) {
+            if (w >= INF) impassable++;
+            else largest = max(largest, w);
+        }
+        double delta = defaultDelta(weights);
+        cout << "  automatic delta " << fixed << setprecision(2) << delta << " (" << impassable << " impassable edges)\n";
+        if (delta > max(1.0, largest)) {
+            cout << "  automatic delta is wider than every usable edge!\n";
+            agree = false;
+        }
+
+        vector<SearchLabels> expected(sources.size());
+        auto clock = chrono::steady_clock::now();
+        for (size_t i = 0; i < sources.size(); i++) sweep(g, sources[i], mode, expected[i]);
+        double baseline = millisSince(clock);
+        printVariant("sweep", baseline, rounds, 0);
+
+        vector<unsigned> threadCounts = {1, 2, 4};
+        if (cores > 4) threadCounts.push_back(cores);
+
+        for (double delta : {0.0, 1.0, 50.0}) {
+            for (unsigned threads : threadCounts) {
+                DeltaStepOptions params;
+                params.delta = delta;
+                params.threads = threads;
+
+                SearchLabels labels;
+                clock = chrono::steady_clock::now();
+                for (size_t i = 0; i < sources.size(); i++) {
+                    deltaStep(g, {{sources[i], 0.0}}, mode, labels, {}, params);
+                    if (labels.dist != expected[i].dist || labels.pred != expected[i].pred) agree = false;
+                }
+
+                ostringstream name;
+                name << "delta " << (delta ? to_string((int) delta) : string("auto")) << ", " << threads << " thr";
+                printVariant(name.str(), millisSince(clock), rounds, baseline);
+            }
+        }
+    }
+
+    cout << (agree ? "All variants agree.\n" : "Variants disagree!\n");
+    return agree ? 0 : 1;
+}
+
+
+static int benchOrder(MapStore &store, unsigned rounds) {
+    shared_ptr<Graph<Location>> cityMap = store.acquire();
+    LiveMap &live = liveMap(cityMap.get());
+    shared_lock<shared_mutex> lock(live.getLock());
+
+    int n = cityMap->getNumVertex();
+    if (n == 0 || rounds == 0) return 1;
+
+    cout << "Benchmark order: " << n << " vertices, " << rounds << " one-to-all searches per mode\n";
+
+    mt19937 random(42);
+    uniform_int_distribution<int> pick(0, n - 1);
+    vector<int> sources;
+    for (unsigned r = 0; r < rounds; r++) sources.push_back(cityMap->getVertexSet()[pick(random)]->getInfo().getId());
+
+    // distances by location ID, from the first order
+    vector<vector<pair<int, double>>> expected;
+    bool agree = true;
+    double baseline = 0;
+
+    for (auto [order, name] : {pair<VertexOrder, string>{VertexOrder::Code, "code"}, {VertexOrder::BFS, "bfs"}, {VertexOrder::RCM, "rcm"}}) {
+        vector<int> positions = computeVertexOrder(*cityMap, order);
+        CompactGraph<Location> g(*cityMap, positions);
+
+        SearchLabels labels;
+        auto clock = chrono::steady_clock::now();
+        for (unsigned r = 0; r < rounds; r++) {
+            for (bool mode : {true, false}) sweep(g, g.findIndex(sources[r]), mode, labels);
+        }
+        double ms = millisSince(clock);
+
+        vector<vector<pair<int, double>>> found;
+        for (unsigned r = 0; r < rounds; r++) {
+            for (bool mode : {true, false}) {
+                sweep(g, g.findIndex(sources[r]), mode, labels);
+                found.emplace_back();
+                for (int v = 0; v < n; v++) found.back().push_back({g.getId(v), labels.dist[v]});
+                sort(found.back().begin(), found.back().end());
+            }
+        }
+
+        cout << "  " << left << setw(6) << name << right << " average edge gap " << fixed << setprecision(1) << setw(8) 
+             << averageEdgeGap(*cityMap, positions) << "\n";
+        printVariant("sweep, " + name + " order", ms, rounds, baseline);
+        if (baseline == 0) baseline = ms;
+
+        if (expected.empty()) expected = found;
+        else if (expected != found) agree = false;
+    }
+
+    cout << (agree ? "All orders agree.\n" : "Orders disagree!\n");
+    return agree ? 0 : 1;
+}
+
+
+static int benchRepair(MapStore &store, unsigned rounds) {
+    shared_ptr<Graph<Location>> original = store.acquire();
+    if (original->getNumVertex() == 0 || rounds == 0) return 1;
+
+    // the updates change the map, so they go to a copy of it
+    shared_ptr<Graph<Location>> cityMap;
+    {
+        shared_lock<shared_mutex> lock(liveMap(original.get()).getLock());
+        cityMap.reset(copyGraph(original.get()), [](Graph<Location> *g) {
+            releaseLiveMap(g);
+            delete g;
+        });
+    }
+    LiveMap &live = liveMap(cityMap.get());
+
+    vector<int> ids;
+    for (auto v : cityMap->getVertexSet()) ids.push_back(v->getInfo().getId());
+    int n = ids.size();
+
+    cout << "Benchmark repair: " << n << " vertices, " << rounds << " batches of 20 segment updates\n";
+
+    mt19937 random(42);
+    uniform_int_distribution<int> pick(0, n - 1);
+    uniform_int_distribution<int> change(0, 3);
+    shared_ptr<RestrictionSet> restrictions = live.getRestrictions({ids[pick(random)], ids[pick(random)], ids[pick(random)]}, {});
+
+    // (source, mode, restricted) of the trees of the last two batches
+    typedef tuple<int, bool, bool> TreeKey;
+    vector<TreeKey> recent, current;
+    double repairMs = 0, rebuildMs = 0;
+    size_t trees = 0, regrown = 0;
+    bool agree = true;
+
+    for (unsigned r = 0; r < rounds; r++) {
+        // new trees, grown only part of the way, besides the complete ones of the earlier batches
+        recent = current;
+        current.clear();
+        for (auto [mode, restricted] : {pair<bool, bool>{true, false}, {true, false}, {false, false}, {true, true}}) {
+            current.emplace_back(ids[pick(random)], mode, restricted);
+            shared_lock<shared_mutex> lock(live.getLock());
+            double dist;
+            live.getSourceTree(get<0>(current.back()), mode, restricted ? restrictions : nullptr)->getPath(ids[pick(random)], dist);
+        }
+
+        // slower, faster, impassable and passable again segments
+        vector<WeightUpdate> updates;
+        for (int i = 0; i < 20; i++) {
+            Vertex<Location> *v = cityMap->getVertexSet()[pick(random)];
+            if (v->getAdj().empty()) continue;
+            Edge<Location> *edge = v->getAdj()[pick(random) % v->getAdj().size()];
+            auto changed = [&](double time) {
+                if (time >= INF) return 10.0;
+                double times[] = {time * 2, max(1.0, floor(time / 2)), INF, time};
+                return times[change(random)];
+            };
+            updates.push_back({v->getInfo().getId(), edge->getDest()->getInfo().getId(), changed(edge->getDriving()), changed(edge->getWalking())});
+        }
+
+        auto clock = chrono::steady_clock::now();
+        live.applyUpdates(updates);
+        repairMs += millisSince(clock);
+        trees += live.getSourceTreeCount();
+
+        // every vertex of the repaired trees must be at the distance of a tree grown on the new weights
+        shared_lock<shared_mutex> lock(live.getLock());
+        auto snapshot = live.getSnapshot();
+        auto mask = restrictions->getMask(*snapshot);
+        auto order = make_shared<const vector<int>>(copyEdgeOrder(*snapshot));
+
+        vector<TreeKey> checked = current;
+        checked.insert(checked.end(), recent.begin(), recent.end());
+        for (auto [source, mode, restricted] : checked) {
+            clock = chrono::steady_clock::now();
+            SourceTree fresh(snapshot, source, mode, restricted ? mask : nullptr, restricted ? order : nullptr);
+            double expectedDist;
+            for (int id : ids) fresh.getPath(id, expectedDist);
+            rebuildMs += millisSince(clock);
+            regrown++;
+
+            shared_ptr<SourceTree> repaired = live.getSourceTree(source, mode, restricted ? restrictions : nullptr);
+            for (int id : ids) {
+                double dist;
+                fresh.getPath(id, expectedDist);
+                repaired->getPath(id, dist);
+                if (dist != expectedDist) agree = false;
+            }
+        }
+    }
+
+    cout << "  " << left << setw(22) << "repair, all trees" << right << fixed << setprecision(3) << setw(10) << repairMs / rounds
+         << " ms/batch (" << setprecision(1) << (double) trees / rounds << " trees)\n";
+    cout << "  " << left << setw(22) << "regrow, one tree" << right << fixed << setprecision(3) << setw(10)
+         << rebuildMs / regrown << " ms/tree\n";
+
+    cout << (agree ? "Repaired trees agree.\n" : "Repaired trees disagree!\n");
+    return agree ? 0 : 1;
+}
+
+
+int runBenchmark(MapStore &store, const string &name, unsigned rounds) {
+    if (name == "relax") return benchRelax(store, rounds);
+    if (name == "multi") return benchMulti(store, rounds);
+    if (name == "delta") return benchDelta(store, rounds);
+    if (name == "order") return benchOrder(store, rounds);
+    if (name == "repair") return benchRepair(store, rounds);
+
+    cerr << "Unknown benchmark " << name << "\n";
+    return 1;
+}
@@ -0,0 +1,57 @@
+/** @file bench.h
+ *  @brief Contains the benchmarks of the search code.
+ *
+ *  This file defines a mode that loads the city map, times some search code on it with
+ *  reproducible random queries and prints the results, instead of starting the menu.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include "MapStore.h"
+#include "loader.h"
+#include "../routes/dijkstra.h"
+#include "../routes/sweep.h"
+#include "../routes/relax.h"
+#include "../routes/multisweep.h"
+#include "../routes/deltastep.h"
+#include "../routes/LiveMap.h"
+
+using namespace std;
+
+
+/**
+ * @brief Runs a benchmark on the current city map.
+ *
+ * - "relax": compares the scalar `relax()` of dijkstra.h with the scalar and AVX2 relaxation
+ *   kernels (see relax.h), alone and inside one-to-one and one-to-all searches, and checks that
+ *   every variant finds the same distances.
+ * - "multi": fills a matrix from `rounds` sources to 16 targets with `initDijkstra` and `dijkstra`
+ *   per pair, with one `sweep` per source and with one `multiSweep` per batch of sources (scalar
+ *   and AVX2 lane kernels), in both modes, and checks that every variant finds the same times.
+ * - "delta": compares one-to-all `sweep`s with `deltaStep` for several bucket widths and thread
+ *   counts, in both modes, and checks that the distances and predecessors are the same, and that
+ *   the automatic width (see `defaultDelta`) isn't wider than the usable edges.
+ * - "order": times one-to-all `sweep`s in both modes on snapshots of the map numbered by location
+ *   code, breadth-first and reverse Cuthill-McKee (see VertexOrder), and checks that the distances
+ *   of every location are the same.
+ * - "repair": on a copy of the map, grows source trees part of the way, applies `rounds` batches of
+ *   random segment updates that repair them, and checks that every location is at the same distance
+ *   in the repaired trees as in trees grown on the new weights.
+ *
+ * @param store Holder of the current city map.
+ * @param name The name of the benchmark.
+ * @param rounds Number of random queries (or sources).
+ * @return 0 if the benchmark ran and the variants agree, 1 otherwise.
+ */
+int runBenchmark(MapStore &store, const string &name, unsigned rounds);
+
+
+#endif
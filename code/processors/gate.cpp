@@ -0,0 +1,528 @@
+#include "gate.h"
+
+using namespace std;
+
+
+/**
+ * @brief Locations and distances of a map, from which a fresh copy of it is built for each pass.
+ */
+struct GateMap {
+    string name;                        ///< Name of the map in the baseline file.
+    map<string, Location> locations;    ///< Locations by code.
+    vector<Distance> distances;         ///< Segments between the locations.
+};
+
+
+/**
+ * @brief A query of the gate and the lines its answer must contain, if it can be checked.
+ */
+struct GateQuery {
+    string kind;                ///< Kind of query, as in the baseline file.
+    string request;             ///< The 'Key:value' lines of the request (see server.h).
+    vector<string> expected;    ///< Lines of the answer computed with `dijkstra`.
+};
+
+
+/**
+ * @brief Values measured for the queries of one kind on one map.
+ */
+struct GateMetrics {
+    double ms = INF;                ///< Time of all the queries in the fastest pass.
+    unsigned long settled = 0;      ///< Vertices settled by their searches.
+    long long allocations = 0;      ///< Blocks allocated by them, in the allocation-counting mode.
+    unsigned long wrong = 0;        ///< Answers different from those of `dijkstra`.
+};
+
+
+static const vector<string> GATE_KINDS = {"independent", "restricted", "eco", "matrix", "isochrone"};
+
+
+/**
+ * @brief Gets the milliseconds elapsed since a moment.
+ */
+static double millisSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+ * @brief Generates a square grid of locations with random driving and walking times.
+ *
+ * About 1% of the locations have parking and 5% of the segments can't be driven.
+ */
+static GateMap generateGrid(int side) {
+    GateMap data;
+    data.name = "grid";
+
+    mt19937 random(7);
+    uniform_int_distribution<int> drive(1, 9), slower(3, 6), chance(0, 99);
+
+    vector<Location> grid;
+    for (int i = 0; i < side * side; i++) {
+        string code = "G" + to_string(i + 1);
+        Location l("GRID " + to_string(i / side) + "/" + to_string(i % side), i + 1, code, chance(random) == 0);
+        data.locations[code] = l;
+        grid.push_back(l);
+    }
+
+    for (int i = 0; i < side * side; i++) {
+        for (int j : {i % side + 1 < side ? i + 1 : -1, i + side < side * side ? i + side : -1}) {
+            if (j == -1) continue;
+            int d = drive(random);
+            data.distances.emplace_back(grid[i], grid[j], chance(random) < 5 ? INF : d, d * slower(random));
+        }
+    }
+    return data;
+}
+
+
+/**
+ * @brief Builds a map, freed together with its LiveMap like those of the MapStore.
+ */
+static shared_ptr<Graph<Location>> buildMap(const GateMap &data) {
+    shared_ptr<Graph<Location>> cityMap(initializeGraph(data.locations, data.distances), [](Graph<Location> *g) {
+        releaseLiveMap(g);
+        delete g;
+    });
+
+    // built before the queries, as by MapStore::reload
+    LiveMap &live = liveMap(cityMap.get());
+    shared_lock<shared_mutex> lock(live.getLock());
+    live.getCatchment();
+    return cityMap;
+}
+
+
+/**
+ * @brief Formats a path and its time as in the text output of the routes.
+ */
+static string pathText(const vector<int> &path, double dist) {
+    if (path.empty()) return "none";
+
+    ostringstream out;
+    writeIds(out, path);
+    out << "(" << (int) dist << ")";
+    return out.str();
+}
+
+
+/**
+ * @brief Generates the queries of the gate on a map, with the answers found by `dijkstra`.
+ */
+static vector<GateQuery> generateQueries(Graph<Location> *cityMap, unsigned rounds) {
+    LiveMap &live = liveMap(cityMap);
+    shared_lock<shared_mutex> lock(live.getLock());
+
+    vector<int> ids;
+    for (auto v : cityMap->getVertexSet()) ids.push_back(v->getInfo().getId());
+    sort(ids.begin(), ids.end());
+
+    mt19937 random(42);
+    uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+    auto location = [&]() { return ids[pick(random)]; };
+
+    vector<GateQuery> queries;
+
+    for (unsigned r = 0; r < max(1u, rounds / 2); r++) {
+        int source = location(), dest = location();
+        GateQuery q = {"independent", "Route:independent\nMode:driving\nSource:" + to_string(source) + "\nDestination:" + to_string(dest) + "\n", {}};
+
+        lock_guard<mutex> labelGuard(live.getLabelLock());
+        if (initDijkstra(cityMap)) dijkstra<DrivingMetric>(cityMap, source, dest);
+        Vertex<Location> *d = cityMap->findLocationId(dest);
+        q.expected.push_back("BestDrivingRoute:" + pathText(getPath(cityMap, source, dest), d->getDist()));
+        queries.push_back(q);
+    }
+
+    for (unsigned r = 0; r < max(1u, rounds / 4); r++) {
+        int source = location(), dest = location(), a = location(), b = location(), c = location(), w = location();
+        if (a == source || a == dest || b == source || b == dest || a == b) continue;
+
+        // every other query has a waypoint, and avoids a segment leaving another location
+        bool waypoint = r % 2 == 1;
+        if (waypoint && (w == a || w == b)) continue;
+        vector<pair<int, int>> segs;
+        Vertex<Location> *from = cityMap->findLocationId(c);
+        if (waypoint && !from->getAdj().empty()) segs.push_back({c, from->getAdj()[0]->getDest()->getInfo().getId()});
+
+        string avoidSegs;
+        for (auto [x, y] : segs) avoidSegs += "(" + to_string(x) + "," + to_string(y) + ")";
+        GateQuery q = {"restricted", "Route:restricted\nMode:driving\nSource:" + to_string(source) + "\nDestination:" + to_string(dest)
+                       + "\nAvoidNodes:" + to_string(a) + "," + to_string(b) + "\nAvoidSegments:" + avoidSegs
+                       + "\nIncludeNode:" + (waypoint ? to_string(w) : "") + "\n", {}};
+
+        // the legs searched by `dijkstra` on a pruned copy, losing the nodes of each leg, as before the searches were shared
+        unique_ptr<Graph<Location>> copy(copyGraph(cityMap));
+        copy->avoidVertices({a, b});
+        copy->avoidEdges(segs);
+
+        vector<int> stops = {source};
+        if (waypoint && w != source && w != dest) stops.push_back(w);
+        stops.push_back(dest);
+
+        vector<int> route;
+        int total = 0;
+        for (size_t i = 0; i + 1 < stops.size(); i++) {
+            Vertex<Location> *to = copy->findLocationId(stops[i + 1]);
+            if (to == nullptr) {
+                route.clear();
+                break;
+            }
+
+            if (initDijkstra(copy.get())) dijkstra<DrivingMetric>(copy.get(), stops[i], stops[i + 1]);
+            vector<int> leg = getPath(copy.get(), stops[i], stops[i + 1]);
+            if (leg.empty()) {
+                route.clear();
+                break;
+            }
+            total += (int) to->getDist();
+
+            if (i + 2 < stops.size()) {
+                leg.pop_back();
+                copy->avoidVertices(leg);
+            }
+            route.insert(route.end(), leg.begin(), leg.end());
+        }
+        q.expected.push_back("RestrictedDrivingRoute:" + pathText(route, total));
+        queries.push_back(q);
+    }
+
+    for (unsigned r = 0; r < max(1u, rounds / 8); r++) {
+        int source = location(), dest = location(), maxWalk = 30;
+        GateQuery q = {"eco", "Route:eco\nMode:driving-walking\nSource:" + to_string(source) + "\nDestination:" + to_string(dest)
+                       + "\nMaxWalkTime:" + to_string(maxWalk) + "\nAvoidNodes:\nAvoidSegments:\n", {}};
+
+        // every parking node searched in full on a copy, as before the searches of the eco routes were shared and pruned
+        unique_ptr<Graph<Location>> copy(copyGraph(cityMap));
+        int bestTotal = 0, bestWalk = 0, bestParking = -1;
+        vector<int> bestDriving, bestWalking;
+
+        for (auto v : cityMap->getVertexSet()) {
+            int parking = v->getInfo().getId();
+            if (!v->getInfo().hasParking() || parking == source || parking == dest) continue;
+
+            if (initDijkstra(copy.get())) dijkstra<DrivingMetric>(copy.get(), source, parking);
+            vector<int> drivingPath = getPath(copy.get(), source, parking);
+            if (drivingPath.empty()) continue;
+            int dt = copy->findLocationId(parking)->getDist();
+
+            // the walk can't go back through the nodes driven through
+            if (initDijkstra(copy.get())) {
+                for (size_t i = 0; i + 1 < drivingPath.size(); i++) copy->findLocationId(drivingPath[i])->setVisited(true);
+                dijkstra<WalkingMetric>(copy.get(), parking, dest);
+            }
+            vector<int> walkingPath = getPath(copy.get(), parking, dest);
+            if (walkingPath.empty()) continue;
+            int wt = copy->findLocationId(dest)->getDist();
+            if (wt > maxWalk) continue;
+
+            if (bestParking == -1 || dt + wt < bestTotal || (dt + wt == bestTotal && wt > bestWalk)) {
+                bestTotal = dt + wt;
+                bestWalk = wt;
+                bestParking = parking;
+                bestDriving = drivingPath;
+                bestWalking = walkingPath;
+            }
+        }
+
+        if (bestParking == -1) {
+            q.expected.push_back("DrivingRoute:none");
+            q.expected.push_back("ParkingNode:none");
+        } else {
+            q.expected.push_back("DrivingRoute:" + pathText(bestDriving, bestTotal - bestWalk));
+            q.expected.push_back("ParkingNode:" + to_string(bestParking));
+            q.expected.push_back("WalkingRoute:" + pathText(bestWalking, bestWalk));
+            q.expected.push_back("TotalTime:" + (bestTotal == 0 ? string() : to_string(bestTotal)));
+        }
+        queries.push_back(q);
+    }
+
+    for (unsigned r = 0; r < max(1u, rounds / 50); r++) {
+        vector<int> sources, targets;
+        for (int i = 0; i < 8; i++) {
+            sources.push_back(location());
+            targets.push_back(location());
+        }
+
+        ostringstream request;
+        request << "Route:matrix\nMode:driving\nSources:";
+        writeIds(request, sources);
+        request << "\nTargets:";
+        writeIds(request, targets);
+        request << "\nPaths:no\n";
+        GateQuery q = {"matrix", request.str(), {}};
+
+        lock_guard<mutex> labelGuard(live.getLabelLock());
+        for (int source : sources) {
+            string row = to_string(source) + ":";
+            for (size_t j = 0; j < targets.size(); j++) {
+                if (initDijkstra(cityMap)) dijkstra<DrivingMetric>(cityMap, source, targets[j]);
+                double dist = cityMap->findLocationId(targets[j])->getDist();
+                row += (j > 0 ? "," : "") + (dist == INF ? string("none") : to_string((int) dist));
+            }
+            q.expected.push_back(row);
+        }
+        queries.push_back(q);
+    }
+
+    for (unsigned r = 0; r < max(1u, rounds / 50); r++) {
+        int source = location(), maxTime = 30;
+        GateQuery q = {"isochrone", "Route:isochrone\nMode:driving\nSource:" + to_string(source) + "\nMaxTime:" + to_string(maxTime) + "\n", {}};
+
+        lock_guard<mutex> labelGuard(live.getLabelLock());
+        SearchLimits limits;
+        limits.maxDist = maxTime;
+        if (initDijkstra(cityMap)) dijkstra<DrivingMetric>(cityMap, source, limits);
+
+        vector<pair<int, int>> reachable;
+        for (auto v : cityMap->getVertexSet()) {
+            if (v->isVisited()) reachable.push_back({(int) v->getDist(), v->getInfo().getId()});
+        }
+        sort(reachable.begin(), reachable.end());
+
+        string line = "ReachableLocations:";
+        for (size_t i = 0; i < reachable.size(); i++) {
+            line += (i > 0 ? "," : "") + to_string(reachable[i].second) + "(" + to_string(reachable[i].first) + ")";
+        }
+        if (reachable.empty()) line += "none";
+        q.expected.push_back(line);
+        q.expected.push_back("ReachableCount:" + to_string(reachable.size()));
+        queries.push_back(q);
+    }
+
+    return queries;
+}
+
+
+/**
+ * @brief Compares `deltaStep` with `sweepFrom` on a map, which `searchFrom` only picks on much larger maps.
+ * @return The number of searches whose distances or predecessors differ.
+ */
+static unsigned long checkDeltaStep(Graph<Location> *cityMap, unsigned rounds) {
+    LiveMap &live = liveMap(cityMap);
+    shared_lock<shared_mutex> lock(live.getLock());
+    auto snapshot = live.getSnapshot();
+    const CompactGraph<Location> &g = *snapshot;
+
+    vector<int> ids;
+    for (auto v : cityMap->getVertexSet()) ids.push_back(v->getInfo().getId());
+    sort(ids.begin(), ids.end());
+
+    mt19937 random(42);
+    uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+    auto location = [&]() { return ids[pick(random)]; };
+
+    // several threads even on one core, so the buckets are really split
+    DeltaStepOptions params;
+    params.threads = 2;
+
+    unsigned long wrong = 0;
+    SearchLabels expected, labels;
+    for (unsigned r = 0; r < max(1u, rounds / 50); r++) {
+        int source = g.findIndex(location());
+
+        // a whole search, and one limited and restricted as those of the isochrones
+        SweepOptions limited;
+        limited.limit = 30;
+        shared_ptr<const SearchMask> mask = live.getRestrictions({location(), location()}, {})->getMask(g);
+        limited.mask = mask.get();
+
+        for (bool mode : {true, false}) {
+            for (const SweepOptions &options : {SweepOptions(), limited}) {
+                sweepFrom(g, {{source, 0.0}}, mode, expected, options);
+                deltaStep(g, {{source, 0.0}}, mode, labels, options, params);
+                if (labels.dist != expected.dist || labels.pred != expected.pred) wrong++;
+            }
+        }
+    }
+    return wrong;
+}
+
+
+/**
+ * @brief Runs the queries on a fresh copy of a map, adding their times and counts to the metrics.
+ * @param check True to count the answers different from the expected ones.
+ */
+static void runPass(const GateMap &data, const vector<GateQuery> &queries, bool check, map<string, GateMetrics> &metrics) {
+    shared_ptr<Graph<Location>> cityMap = buildMap(data);
+    LiveMap &live = liveMap(cityMap.get());
+    map<string, double> ms;
+
+    for (const GateQuery &q : queries) {
+        string error;
+        Route *route = parseRequest(cityMap.get(), q.request, error);
+        if (!route) {
+            metrics[q.kind].wrong++;
+            continue;
+        }
+
+        SearchStats stats;
+        ostringstream out;
+        {
+            shared_lock<shared_mutex> lock(live.getLock());
+            StatsScope scope(&stats);
+            auto clock = chrono::steady_clock::now();
+            route->processRoute(out);
+            ms[q.kind] += millisSince(clock);
+            scope.flush();
+        }
+        delete route;
+
+        if (!check) continue;
+        metrics[q.kind].settled += stats.settled;
+        metrics[q.kind].allocations += stats.allocations;
+
+        string result = "\n" + out.str();
+        for (const string &line : q.expected) {
+            if (result.find("\n" + line + "\n") == string::npos) {
+                metrics[q.kind].wrong++;
+                break;
+            }
+        }
+    }
+
+    for (auto &[kind, total] : ms) metrics[kind].ms = min(metrics[kind].ms, total);
+}
+
+
+/**
+ * @brief Checks whether a metric is a latency, which is noisy, rather than a count, which is deterministic.
+ */
+static bool isLatency(const string &key) {
+    return key.size() >= 3 && key.compare(key.size() - 3, 3, " ms") == 0;
+}
+
+
+/**
+ * @brief Reads the baseline file.
+ * @return False if the file couldn't be opened.
+ */
+static bool readBaseline(const string &filename, unsigned &rounds, map<string, double> &values) {
+    ifstream file(filename);
+    if (!file.is_open()) return false;
+
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        stringstream ss(line);
+        string first;
+        ss >> first;
+
+        if (first == "rounds") ss >> rounds;
+        else {
+            string kind, metric;
+            double value;
+            if (ss >> kind >> metric >> value) values[first + " " + kind + " " + metric] = value;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Compares a metric with its baseline, printing both.
+ * @return True if it didn't regress (or has no baseline).
+ */
+static bool compareMetric(const string &key, double value, double tolerance, double slack, const map<string, double> &baseline) {
+    int decimals = slack > 0 ? 3 : 0;
+    cout << "  " << left << setw(30) << key << right << fixed << setprecision(decimals) << setw(14) << value;
+
+    auto it = baseline.find(key);
+    if (it == baseline.end()) {
+        cout << "  (no baseline)\n";
+        return true;
+    }
+
+    // only a change beyond the tolerance counts, either way
+    bool ok = value <= it->second * (1 + tolerance) + slack;
+    bool better = value * (1 + tolerance) + slack < it->second;
+    cout << setw(14) << it->second << "  " << (ok ? (better ? "better" : "ok") : "REGRESSED") << "\n";
+    return ok;
+}
+
+
+int runGate(const string &locationsFile, const string &distancesFile, const string &baselineFile, bool update, unsigned rounds) {
+    if (rounds == 0) return 1;
+
+    vector<GateMap> maps(1);
+    maps[0].name = "bundled";
+    if (!loadLocations(locationsFile, maps[0].locations) || !loadDistances(distancesFile, maps[0].locations, maps[0].distances)) return 1;
+    maps.push_back(generateGrid(GATE_GRID_SIDE));
+
+    bool counting = allocationCountingEnabled();
+    cout << "Performance gate: " << rounds << " rounds, " << GATE_PASSES << " passes, allocation counting "
+         << (counting ? "enabled" : "disabled") << "\n";
+
+    // measured values, by "<map> <kind> <metric>"
+    map<string, double> values;
+    bool correct = true;
+
+    for (const GateMap &data : maps) {
+        vector<GateQuery> queries;
+        {
+            shared_ptr<Graph<Location>> reference = buildMap(data);
+            queries = generateQueries(reference.get(), rounds);
+
+            if (unsigned long wrong = checkDeltaStep(reference.get(), rounds)) {
+                cout << "  deltaStep: " << wrong << " searches differ from sweepFrom!\n";
+                correct = false;
+            }
+        }
+        cout << "Map " << data.name << ": " << data.locations.size() << " locations, " << data.distances.size() << " segments, "
+             << queries.size() << " queries\n";
+
+        map<string, GateMetrics> metrics;
+        for (unsigned pass = 0; pass < GATE_PASSES; pass++) runPass(data, queries, pass == 0, metrics);
+
+        for (const string &kind : GATE_KINDS) {
+            const GateMetrics &m = metrics[kind];
+            string prefix = data.name + " " + kind + " ";
+            values[prefix + "ms"] = m.ms;
+            values[prefix + "settled"] = m.settled;
+            if (counting) values[prefix + "allocations"] = m.allocations;
+
+            if (m.wrong > 0) {
+                cout << "  " << kind << ": " << m.wrong << " answers differ from dijkstra!\n";
+                correct = false;
+            }
+        }
+    }
+
+    if (update) {
+        ofstream file(baselineFile);
+        if (!file.is_open()) {
+            cerr << "Couldn't write the baseline file " << baselineFile << "\n";
+            return 1;
+        }
+        file << "# Baseline of the performance gate (--bench gate), written by --bench gate-update\n";
+        file << "# <map> <queries> <metric> <value>\n";
+        file << "rounds " << rounds << "\n";
+        for (auto &[key, value] : values) file << key << " " << fixed << setprecision(isLatency(key) ? 3 : 0) << value << "\n";
+
+        cout << "Baseline written to " << baselineFile << "\n";
+        return correct ? 0 : 1;
+    }
+
+    unsigned baselineRounds = 0;
+    map<string, double> baseline;
+    if (!readBaseline(baselineFile, baselineRounds, baseline)) {
+        cerr << "Couldn't read the baseline file " << baselineFile << " (write one with --bench gate-update)\n";
+        return 1;
+    }
+    if (baselineRounds != rounds) {
+        cerr << "The baseline was measured with " << baselineRounds << " rounds, not " << rounds << "\n";
+        return 1;
+    }
+
+    cout << "  " << left << setw(30) << "metric" << right << setw(14) << "value" << setw(14) << "baseline" << "\n";
+    bool regressed = false;
+    for (auto &[key, value] : values) {
+        bool ms = isLatency(key);
+        if (!compareMetric(key, value, ms ? GATE_LATENCY_TOLERANCE : GATE_COUNT_TOLERANCE, ms ? GATE_LATENCY_SLACK_MS : 0, baseline)) regressed = true;
+    }
+
+    if (!correct) cout << "Some answers differ from dijkstra!\n";
+    if (regressed) cout << "Some metrics regressed!\n";
+    if (correct && !regressed) cout << "No regressions.\n";
+    return correct && !regressed ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+/** @file gate.h
+ *  @brief Contains the performance regression gate.
+ *
+ *  This file defines a mode that runs a fixed, reproducible set of queries on the bundled city map
+ *  and on a generated grid map larger than it, and compares the latency, the allocations and
+ *  the settled vertices of each kind of query with the values stored in a baseline file, failing
+ *  when any of them got worse by more than its tolerance. The same run checks the answers of every
+ *  kind of query against `dijkstra` on the map or on a pruned copy of it, built without the caches
+ *  under test, so a faster search can't change them unnoticed. It also checks `deltaStep` against
+ *  `sweepFrom` directly, since both maps are below DELTA_STEP_MIN_VERTICES.
+ *
+ *  The baseline file has one line per metric, "<map> <queries> <metric> <value>", after a line
+ *  "rounds <rounds>" with the size of the query set it was measured with. Lines starting with '#'
+ *  are comments. Allocations are only measured in the allocation-counting mode (see memory.h), and
+ *  only compared if the baseline has them.
+ */
+
+#ifndef GATE_H
+#define GATE_H
+
+#include <map>
+#include <string>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include "loader.h"
+#include "server.h"
+#include "memory.h"
+#include "../routes/dijkstra.h"
+#include "../routes/deltastep.h"
+#include "../routes/LiveMap.h"
+#include "../routes/SearchStats.h"
+#include "../routes/RestrictionSet.h"
+
+using namespace std;
+
+
+const double GATE_LATENCY_TOLERANCE = 0.5;      ///< Relative growth of the latency accepted by the gate.
+const double GATE_LATENCY_SLACK_MS = 2;         ///< Growth of the latency in milliseconds always accepted (timer noise).
+const double GATE_COUNT_TOLERANCE = 0.01;       ///< Relative growth of the settled vertices and the allocations accepted.
+const unsigned GATE_PASSES = 5;                 ///< Timed passes over the queries, of which the fastest counts.
+const int GATE_GRID_SIDE = 60;                  ///< Side of the generated grid map, in locations.
+
+
+/**
+ * @brief Runs the performance regression gate.
+ *
+ * @param locationsFile The name of the CSV file containing the bundled locations.
+ * @param distancesFile The name of the CSV file containing the bundled distances.
+ * @param baselineFile The name of the baseline file.
+ * @param update True to write the measured values to the baseline file instead of comparing them.
+ * @param rounds Size of the query set on each map: rounds / 2 independent, rounds / 4 restricted, rounds / 8 eco and
+ *        rounds / 50 matrix and isochrone queries.
+ * @return 0 if every answer is right and no metric regressed, 1 otherwise.
+ */
+int runGate(const string &locationsFile, const string &distancesFile, const string &baselineFile, bool update, unsigned rounds);
+
+
+#endif
@@ -2,20 +2,17 @@
 
 using namespace std;
 
-map<string, Location> locations;
-vector<Distance> distances;
-
-
 // ===== LOADING FUNCTIONS =====
 
-void loadLocations(const string &filename){
+bool loadLocations(const string &filename, map<string, Location> &locations){
+    TRACE_SCOPE("loadLocations", "load");
     locations.clear();
 
     ifstream file(filename);
 
     if (!file.is_open()) {
         cerr << "\nError opening Locations file: " << filename << endl;
-        return;
+        return false;
     }
 
     string line;
@@ -31,61 +28,253 @@ void loadLocations(const string &filename){
         getline(ss, code, ',');
         getline(ss, parking, ',');
 
-        Location loc(name, stoi(id), code, stoi(parking));
-        locations[code] = loc;
+        try {
+            Location loc(name, stoi(id), code, stoi(parking));
+            locations[code] = loc;
+        } catch (const logic_error &e) {
+            // e.g. a file that is still being written
+            cerr << "\nInvalid line in Locations file: " << line << endl;
+            return false;
+        }
     }
 
     file.close();
     cout << "\nLoaded " << locations.size() << " locations successfully.";
+    return true;
 }
 
 
-void loadDistances(const string &filename){
-    
-    distances.clear();
+// files smaller than this are parsed on the calling thread
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
 
-    ifstream file(filename);
 
-    if (!file.is_open()) {
-        cerr << "\nError opening Distances file: " << filename << endl;
-        return;
-    }
+/**
+ * @brief Parses the lines of one chunk of the Distances file.
+ *
+ * Codes that are not in `locations` are resolved to a default Location and recorded
+ * in `missing`, so they can be added to the map after all chunks are merged. Lines with
+ * a time that isn't a number nor "X" (e.g. out of the range of an int) are recorded in `invalid`.
+ */
+static void parseDistanceChunk(const char *begin, const char *end, const map<string, Location> &locations, vector<Distance> &out, 
+                               vector<string> &missing, vector<string> &invalid) {
+    TRACE_SCOPE("parseDistanceChunk", "load");
 
-    string line;
-    getline(file, line); // skip header
+    const char *p = begin;
 
-    while (getline(file, line)) {
-        stringstream ss(line);
-        string loc1, loc2, driv, walk;
-        int d_num, w_num;
+    while (p < end) {
+        const char *eol = find(p, end, '\n');
+        string fields[4];
+
+        // same splitting as getline(ss, field, ',') on each of the 4 fields
+        const char *f = p;
+        for (int i = 0; i < 4 && f < eol; i++) {
+            const char *comma = find(f, eol, ',');
+            fields[i].assign(f, comma);
+            f = (comma == eol) ? eol : comma + 1;
+        }
 
-        getline(ss, loc1, ',');
-        getline(ss, loc2, ',');
-        getline(ss, driv, ',');
-        getline(ss, walk, ',');
+        Location l1, l2;
+        auto it1 = locations.find(fields[0]);
+        if (it1 != locations.end()) l1 = it1->second;
+        else missing.push_back(fields[0]);
 
-        Location l1 = locations[loc1];
-        Location l2 = locations[loc2];
+        auto it2 = locations.find(fields[1]);
+        if (it2 != locations.end()) l2 = it2->second;
+        else missing.push_back(fields[1]);
+
+        int d_num, w_num;
+        const char *next = (eol == end) ? end : eol + 1;
 
         // if driv or walk = "X"
-        try {d_num = stoi(driv);}
+        try {d_num = stoi(fields[2]);}
         catch (const invalid_argument &e) {d_num = INF;}
+        catch (const logic_error &e) {
+            invalid.emplace_back(p, eol);
+            p = next;
+            continue;
+        }
 
-        try {w_num = stoi(walk);}
+        try {w_num = stoi(fields[3]);}
         catch (const invalid_argument &e) {w_num = INF;}
+        catch (const logic_error &e) {
+            invalid.emplace_back(p, eol);
+            p = next;
+            continue;
+        }
+
+        out.emplace_back(l1, l2, d_num, w_num);
+
+        p = next;
+    }
+}
 
-        Distance dist(l1, l2, d_num, w_num);
-        distances.push_back(dist);
+
+bool loadDistances(const string &filename, map<string, Location> &locations, vector<Distance> &distances, unsigned threads){
+    TRACE_SCOPE("loadDistances", "load");
+    
+    distances.clear();
+
+    ifstream file(filename, ios::binary);
+
+    if (!file.is_open()) {
+        cerr << "\nError opening Distances file: " << filename << endl;
+        return false;
     }
 
+    stringstream buffer;
+    buffer << file.rdbuf();
     file.close();
+    string content = buffer.str();
+
+    // skip header
+    size_t headerEnd = content.find('\n');
+    const char *begin = content.data() + (headerEnd == string::npos ? content.size() : headerEnd + 1);
+    const char *end = content.data() + content.size();
+
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    size_t bytes = end - begin;
+    size_t numChunks = min<size_t>(threads, max<size_t>(1, bytes / MIN_CHUNK_BYTES));
+
+    // newline-aligned chunk boundaries
+    vector<const char *> bounds = {begin};
+    for (size_t i = 1; i < numChunks; i++) {
+        const char *cut = max(bounds.back(), begin + bytes * i / numChunks);
+        cut = find(cut, end, '\n');
+        bounds.push_back(cut == end ? end : cut + 1);
+    }
+    bounds.push_back(end);
+
+    vector<vector<Distance>> parsed(numChunks);
+    vector<vector<string>> missing(numChunks);
+    vector<vector<string>> invalid(numChunks);
+
+    if (numChunks == 1) {
+        parseDistanceChunk(bounds[0], bounds[1], locations, parsed[0], missing[0], invalid[0]);
+    } else {
+        vector<thread> workers;
+        for (size_t i = 0; i < numChunks; i++) {
+            workers.emplace_back(parseDistanceChunk, bounds[i], bounds[i + 1], cref(locations), ref(parsed[i]), ref(missing[i]), ref(invalid[i]));
+        }
+        for (auto &t : workers) t.join();
+    }
+
+    for (auto &lines : invalid) {
+        if (lines.empty()) continue;
+        // e.g. a file that is still being written
+        cerr << "\nInvalid line in Distances file: " << lines.front() << endl;
+        return false;
+    }
+
+    // merge in file order
+    size_t total = 0;
+    for (auto &chunk : parsed) total += chunk.size();
+    distances.reserve(total);
+
+    for (size_t i = 0; i < numChunks; i++) {
+        move(parsed[i].begin(), parsed[i].end(), back_inserter(distances));
+        for (auto &code : missing[i]) locations.emplace(code, Location());
+    }
+
     cout << "\nLoaded " << distances.size() << " distances successfully.\n\n";
+    return true;
 }
 
 
 // ===== GRAPH FUNCTIONS =====
 
-Graph<Location> *initializeGraph() {
+static atomic<VertexOrder> vertexOrder{VertexOrder::Code};
+
+
+bool setVertexOrder(const string &name) {
+    if (name == "code") vertexOrder = VertexOrder::Code;
+    else if (name == "bfs") vertexOrder = VertexOrder::BFS;
+    else if (name == "rcm") vertexOrder = VertexOrder::RCM;
+    else {
+        cerr << "Unknown vertex order " << name << " (expected code, bfs or rcm)\n";
+        return false;
+    }
+    return true;
+}
+
+
+VertexOrder getVertexOrder() {
+    return vertexOrder;
+}
+
+
+vector<int> computeVertexOrder(const Graph<Location> &g, VertexOrder order) {
+    const auto &vertices = g.getVertexSet();
+    int n = vertices.size();
+
+    vector<int> res(n);
+    for (int i = 0; i < n; i++) res[i] = i;
+    if (order == VertexOrder::Code) return res;
+
+    unordered_map<const Vertex<Location> *, int> position;
+    for (int i = 0; i < n; i++) position[vertices[i]] = i;
+
+    vector<vector<int>> neighbours(n);
+    for (int i = 0; i < n; i++) {
+        for (auto e : vertices[i]->getAdj()) {
+            int j = position[e->getDest()];
+            if (j != i) neighbours[i].push_back(j);
+        }
+        sort(neighbours[i].begin(), neighbours[i].end());
+        neighbours[i].erase(unique(neighbours[i].begin(), neighbours[i].end()), neighbours[i].end());
+    }
+
+    // RCM starts each component from a vertex of lowest degree and visits neighbours by degree
+    bool rcm = (order == VertexOrder::RCM);
+    auto byDegree = [&](int a, int b) {
+        return make_pair(neighbours[a].size(), a) < make_pair(neighbours[b].size(), b);
+    };
+    vector<int> starts = res;
+    if (rcm) {
+        sort(starts.begin(), starts.end(), byDegree);
+        for (auto &list : neighbours) sort(list.begin(), list.end(), byDegree);
+    }
+
+    res.clear();
+    vector<char> visited(n, 0);
+    for (int s : starts) {
+        if (visited[s]) continue;
+        visited[s] = 1;
+        size_t head = res.size();
+        res.push_back(s);
+        while (head < res.size()) {
+            int v = res[head++];
+            for (int w : neighbours[v]) {
+                if (!visited[w]) {
+                    visited[w] = 1;
+                    res.push_back(w);
+                }
+            }
+        }
+    }
+
+    if (rcm) reverse(res.begin(), res.end());
+    return res;
+}
+
+
+double averageEdgeGap(const Graph<Location> &g, const vector<int> &order) {
+    const auto &vertices = g.getVertexSet();
+    unordered_map<const Vertex<Location> *, long> position;
+    for (size_t i = 0; i < vertices.size(); i++) position[order.empty() ? vertices[i] : vertices[order[i]]] = i;
+
+    double total = 0;
+    size_t edges = 0;
+    for (auto v : vertices) {
+        for (auto e : v->getAdj()) {
+            total += labs(position[v] - position[e->getDest()]);
+            edges++;
+        }
+    }
+    return edges ? total / edges : 0;
+}
+
+Graph<Location> *initializeGraph(const map<string, Location> &locations, const vector<Distance> &distances) {
+    TRACE_SCOPE("initializeGraph", "load");
 
     Graph<Location> *cityMap = new Graph<Location>();
 
@@ -96,12 +285,48 @@ Graph<Location> *initializeGraph() {
 
     // process distances as edges
     for (auto &d : distances) {
-        Location l1 = d.getSource();
-        Location l2 = d.getDestination();
+        const Location &l1 = d.getSource();
+        const Location &l2 = d.getDestination();
         int driv = d.getDriving();
         double walk = d.getWalking();
         cityMap->addBidirectionalEdge(l1, l2, driv, walk);
     }
 
+    if (vertexOrder != VertexOrder::Code) {
+        TRACE_SCOPE("reorderVertices", "load");
+        cityMap->reorderVertices(computeVertexOrder(*cityMap, vertexOrder));
+    }
+
     return cityMap;
-}
\ No newline at end of file
+}
+
+
+size_t locationsMemory(const map<string, Location> &locations) {
+    // each tree node has a color and three links besides the pair
+    size_t bytes = sizeof(locations);
+    for (auto &l : locations) bytes += 4 * sizeof(void *) + sizeof(l) + stringHeapBytes(l.first);
+    return bytes;
+}
+
+
+size_t distancesMemory(const vector<Distance> &distances) {
+    return sizeof(distances) + distances.capacity() * sizeof(Distance);
+}
+
+
+Graph<Location> *loadCityMap(const string &locationsFile, const string &distancesFile, LoadMemory *memory) {
+    map<string, Location> locations;
+    vector<Distance> distances;
+
+    if (!loadLocations(locationsFile, locations) || locations.empty()) return nullptr;
+    if (!loadDistances(distancesFile, locations, distances)) return nullptr;
+
+    Graph<Location> *cityMap = initializeGraph(locations, distances);
+
+    if (memory) {
+        memory->locations = locationsMemory(locations);
+        memory->distances = distancesMemory(distances);
+        memory->graph = cityMap->getMemoryUsage();
+    }
+    return cityMap;
+}
@@ -14,39 +14,141 @@
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <atomic>
+#include <unordered_map>
 #include "../data_structures/Location.h"
 #include "../data_structures/Distance.h"
 #include "../data_structures/Graph.h"
+#include "trace.h"
+#include "memory.h"
 
 using namespace std;
 
 
-//maps
-extern map<string, Location> locations;    ///< Stores locations indexed by their codes.
-extern vector<Distance> distances;         ///< Stores distances between locations.
+/**
+ * @brief Bytes used by the containers of one load of the data sets.
+ *
+ * The containers are freed once the graph is built, so these are the extra bytes needed 
+ * while a map is being (re)loaded.
+ */
+struct LoadMemory {
+    size_t locations = 0;   ///< Bytes used by the map of locations.
+    size_t distances = 0;   ///< Bytes used by the vector of distances.
+    size_t graph = 0;       ///< Bytes used by the graph built from them.
+};
+
+
+/**
+ * @brief Order of the vertices of the city map.
+ *
+ * The vertices are numbered in this order by the snapshots of the map (see CompactGraph),
+ * so an order where neighbouring locations get close numbers keeps the labels of a search
+ * that are read together close in memory.
+ */
+enum class VertexOrder {
+    Code,   ///< By location code, the order of the data sets (the default).
+    BFS,    ///< Breadth-first from the first location of each connected component.
+    RCM     ///< Reverse Cuthill-McKee: breadth-first from a vertex of lowest degree, neighbours by degree, reversed.
+};
+
+
+/**
+ * @brief Chooses the order of the vertices of the maps loaded from now on.
+ * @param name "code", "bfs" or "rcm".
+ * @return True if the name is valid, false otherwise.
+ */
+bool setVertexOrder(const string &name);
+
+/**
+ * @brief Gets the order of the vertices of the maps loaded from now on.
+ * @return The order chosen with `setVertexOrder`.
+ */
+VertexOrder getVertexOrder();
+
+/**
+ * @brief Computes an order of the vertices of a graph.
+ * @param g The graph.
+ * @param order The kind of order.
+ * @return The position in `g.getVertexSet()` of the vertex to place at each position.
+ */
+vector<int> computeVertexOrder(const Graph<Location> &g, VertexOrder order);
+
+/**
+ * @brief Computes the average distance between the positions of the two ends of each edge.
+ * @param g The graph.
+ * @param order The position in `g.getVertexSet()` of the vertex placed at each position (empty for the current order).
+ * @return The average gap, smaller when neighbours are closer in memory.
+ */
+double averageEdgeGap(const Graph<Location> &g, const vector<int> &order = {});
 
 
 /**
  * @brief Loads location data from a CSV file.
  *
  * @param filename The name of the CSV file containing location data.
+ * @param locations Map where the locations are stored, indexed by their codes.
+ * @return True if the file was read successfully, false otherwise.
  */
-void loadLocations(const string &filename);
+bool loadLocations(const string &filename, map<string, Location> &locations);
 
 /**
  * @brief Loads distance data from a CSV file.
  *
+ * Large files are split into newline-aligned chunks that are parsed in parallel into
+ * per-thread buffers, which are then merged in file order, so the result is the same
+ * as loading the file line by line.
+ *
  * @param filename The name of the CSV file containing distance data.
+ * @param locations The loaded locations. Codes that are not in it are added as default locations.
+ * @param distances Vector where the distances are stored.
+ * @param threads Number of parsing threads (0 uses the hardware concurrency).
+ * @return True if the file was read successfully, false otherwise.
  */
-void loadDistances(const string &filename);
+bool loadDistances(const string &filename, map<string, Location> &locations, vector<Distance> &distances, unsigned threads = 0);
 
 
 /**
- * @brief Initializes the main graph using loaded location and distance data.
+ * @brief Initializes a graph using loaded location and distance data.
  *
+ * The vertices are added by location code and then reordered as chosen with `setVertexOrder`.
+ * The IDs of the locations don't change.
+ *
+ * @param locations The loaded locations.
+ * @param distances The loaded distances.
  * @return A pointer to the initialized graph.
  */
-Graph<Location>* initializeGraph();
+Graph<Location>* initializeGraph(const map<string, Location> &locations, const vector<Distance> &distances);
+
+/**
+ * @brief Computes the number of bytes used by a map of locations.
+ * @param locations The locations.
+ * @return The number of bytes used by the tree nodes and their keys.
+ */
+size_t locationsMemory(const map<string, Location> &locations);
+
+/**
+ * @brief Computes the number of bytes used by a vector of distances.
+ * @param distances The distances.
+ * @return The number of bytes used, counting the capacity of the vector.
+ */
+size_t distancesMemory(const vector<Distance> &distances);
+
+/**
+ * @brief Loads both data sets and builds the city map from them.
+ *
+ * The data is loaded into local containers, so this can run while other threads use a
+ * previously loaded map.
+ *
+ * @param locationsFile The name of the CSV file containing location data.
+ * @param distancesFile The name of the CSV file containing distance data.
+ * @param memory If given, set to the bytes used by the containers and the graph.
+ * @return A pointer to the new graph, or nullptr if a file couldn't be read.
+ */
+Graph<Location>* loadCityMap(const string &locationsFile, const string &distancesFile, LoadMemory *memory = nullptr);
 
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "memory.h"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include "MapStore.h"
+#include "../routes/LiveMap.h"
+#include "../routes/RouteCache.h"
+
+#ifdef DA_COUNT_ALLOCATIONS
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+
+// constant-initialized, so they can be used by operator new before anything else is constructed
+static thread_local AllocationCounters counters;
+static atomic<unsigned long> totalAllocations{0};
+static atomic<unsigned long> totalFrees{0};
+static atomic<long long> totalAllocated{0};
+static atomic<long long> totalLive{0};
+static atomic<long long> totalPeak{0};
+
+
+bool allocationCountingEnabled() {
+#ifdef DA_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+AllocationCounters &threadAllocations() {
+    return counters;
+}
+
+
+AllocationCounters processAllocations() {
+    AllocationCounters c;
+    c.allocations = totalAllocations;
+    c.frees = totalFrees;
+    c.allocatedBytes = totalAllocated;
+    c.liveBytes = totalLive;
+    c.peakBytes = totalPeak;
+    return c;
+}
+
+
+#ifdef DA_COUNT_ALLOCATIONS
+
+// array, nothrow and sized forms of the standard library forward to these two
+
+void *operator new(size_t size) {
+    void *p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+
+    long long bytes = malloc_usable_size(p);
+    counters.allocations++;
+    counters.allocatedBytes += bytes;
+    counters.liveBytes += bytes;
+    if (counters.liveBytes > counters.peakBytes) counters.peakBytes = counters.liveBytes;
+
+    totalAllocations.fetch_add(1, memory_order_relaxed);
+    totalAllocated.fetch_add(bytes, memory_order_relaxed);
+    long long live = totalLive.fetch_add(bytes, memory_order_relaxed) + bytes;
+    long long peak = totalPeak.load(memory_order_relaxed);
+    while (live > peak && !totalPeak.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+    return p;
+}
+
+
+void operator delete(void *p) noexcept {
+    if (!p) return;
+
+    long long bytes = malloc_usable_size(p);
+    counters.frees++;
+    counters.liveBytes -= bytes;
+
+    totalFrees.fetch_add(1, memory_order_relaxed);
+    totalLive.fetch_sub(bytes, memory_order_relaxed);
+    free(p);
+}
+
+
+void operator delete(void *p, size_t) noexcept {
+    ::operator delete(p);
+}
+
+#endif
+
+
+void writeMemoryReport(ostream &out, MapStore &store) {
+    shared_ptr<Graph<Location>> cityMap = store.acquire();
+    LoadMemory load = store.getLoadMemory();
+
+    if (cityMap) {
+        size_t edges = 0;
+        for (auto v : cityMap->getVertexSet()) edges += v->getAdj().size();
+
+        out << "CityMap:" << cityMap->getMemoryUsage() << " bytes (" << cityMap->getNumVertex() << " vertices, " << edges << " edges)\n";
+        LiveMap &live = liveMap(cityMap.get());
+        out << "Derived:" << live.getMemoryUsage() << " bytes (snapshot, trees and " << live.getRestrictionCount() << " restriction sets)\n";
+    }
+
+    out << "InternedStrings:" << Location::getInternedBytes() << " bytes\n";
+    out << "LoadedLocations:" << load.locations << " bytes\n";
+    out << "LoadedDistances:" << load.distances << " bytes\n";
+    out << "RouteCache:" << routeCache().getBytes() << " bytes\n";
+
+    if (allocationCountingEnabled()) {
+        AllocationCounters heap = processAllocations();
+        out << "HeapLive:" << heap.liveBytes << " bytes\n";
+        out << "HeapPeak:" << heap.peakBytes << " bytes\n";
+        out << "HeapAllocations:" << heap.allocations << " (" << heap.frees << " freed)\n";
+    }
+}
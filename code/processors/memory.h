@@ -0,0 +1,82 @@
+/** @file memory.h
+ *  @brief Contains the memory accounting of the program.
+ *
+ *  This file defines the counters of the optional allocation-counting mode, which replaces the
+ *  global `operator new` and `operator delete` to count the allocations made by every thread,
+ *  and a report of the bytes used by the current city map and everything derived from it.
+ *  Allocation counting is only compiled in when DA_COUNT_ALLOCATIONS is defined (CMake option
+ *  `-DDA_COUNT_ALLOCATIONS=ON`), so the default build allocates exactly as before.
+ */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <string>
+#include <ostream>
+
+using namespace std;
+
+
+class MapStore;
+
+
+/**
+ * @brief Allocations counted by the allocation-counting mode.
+ */
+struct AllocationCounters {
+    unsigned long allocations = 0;  ///< Number of blocks allocated.
+    unsigned long frees = 0;        ///< Number of blocks freed.
+    long long allocatedBytes = 0;   ///< Bytes allocated, in total.
+    long long liveBytes = 0;        ///< Bytes allocated and not freed yet (negative for a thread that frees what others allocated).
+    long long peakBytes = 0;        ///< Highest value of `liveBytes` since it was last reset.
+};
+
+
+/**
+ * @brief Checks whether allocations are being counted.
+ * @return True if the allocation-counting mode was compiled in.
+ */
+bool allocationCountingEnabled();
+
+/**
+ * @brief Gets the allocation counters of the current thread.
+ *
+ * `peakBytes` may be reset to `liveBytes` to measure the peak of a part of the program.
+ *
+ * @return A reference to the counters of the thread (all zero if counting is disabled).
+ */
+AllocationCounters &threadAllocations();
+
+/**
+ * @brief Gets the allocation counters of the whole process.
+ * @return A copy of the counters.
+ */
+AllocationCounters processAllocations();
+
+
+/**
+ * @brief Computes the number of heap bytes used by the characters of a string.
+ * @param s The string.
+ * @return The size of its buffer, or 0 if it fits in the string object itself.
+ */
+inline size_t stringHeapBytes(const string &s) {
+    const char *p = s.data();
+    bool local = p >= reinterpret_cast<const char *>(&s) && p < reinterpret_cast<const char *>(&s + 1);
+    return local ? 0 : s.capacity() + 1;
+}
+
+
+/**
+ * @brief Writes how many bytes the current city map and the data derived from it use.
+ *
+ * Reports the graph, the compact snapshot, cached trees and restriction sets of the map (see LiveMap),
+ * the interned strings of the locations, the containers of the last load, the route cache and, in
+ * the allocation-counting mode, the heap of the whole process.
+ *
+ * @param out The output stream.
+ * @param store Holder of the current city map.
+ */
+void writeMemoryReport(ostream &out, MapStore &store);
+
+
+#endif
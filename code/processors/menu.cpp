@@ -7,7 +7,7 @@ using namespace std;
 
 // ================================= ROUTE =================================
 
-void chooseRoute(Graph<Location>* cityMap) {
+void chooseRoute(MapStore &store) {
 
     char choice;
 
@@ -16,6 +16,12 @@ void chooseRoute(Graph<Location>* cityMap) {
         cout << "1. Independent Route Planning -> driving\n";
         cout << "2. Restricted Route Planning -> driving\n";
         cout << "3. Best route for driving and walking\n";
+        cout << "4. Distance matrix -> driving or walking\n";
+        cout << "5. Isochrone -> locations reachable within a time budget\n";
+        cout << "6. Update segment times from a file\n";
+        cout << "7. Reload the city data\n";
+        cout << "8. Show query metrics\n";
+        cout << "9. Show memory usage\n";
         cout << "E. Exit\n";
         cout << "Select an option: ";
         cin >> choice;
@@ -26,7 +32,30 @@ void chooseRoute(Graph<Location>* cityMap) {
             case '2':
             case '3':
                 cout << "\nGreat! Going to next step...\n\n";
-                chooseMode(cityMap, choice);
+                chooseMode(store, choice);
+                break;
+
+            case '4':
+            case '5':
+                // multi-location queries are only read from files
+                cout << "\nGoing to batch mode...\n";
+                batchMode(store, choice);
+                break;
+
+            case '6':
+                updateMode(store);
+                break;
+
+            case '7':
+                reloadMode(store);
+                break;
+
+            case '8':
+                metricsMode();
+                break;
+
+            case '9':
+                memoryMode(store);
                 break;
 
             case 'e':
@@ -48,7 +77,7 @@ void chooseRoute(Graph<Location>* cityMap) {
 
 // ================================= MODE =================================
 
-void chooseMode(Graph<Location>* cityMap, char choice) {
+void chooseMode(MapStore &store, char choice) {
 
     char mode;
 
@@ -65,12 +94,12 @@ void chooseMode(Graph<Location>* cityMap, char choice) {
         switch(mode) {
             case '1':
                 cout << "\nGoing to interactive mode...\n\n";
-                interactMode(cityMap, choice);
+                interactMode(store, choice);
                 break;
 
             case '2':
                 cout << "\nGoing to batch mode...\n";
-                batchMode(cityMap, choice);
+                batchMode(store, choice);
                 break;
 
             case 'r':
@@ -94,7 +123,7 @@ void chooseMode(Graph<Location>* cityMap, char choice) {
 
 
 
-void interactMode(Graph<Location>* cityMap, char choice) {
+void interactMode(MapStore &store, char choice) {
     string mode;
     int source = -1, dest = -1;
 
@@ -102,6 +131,10 @@ void interactMode(Graph<Location>* cityMap, char choice) {
 
     while (keepRunning) {
 
+        // the map stays alive until this query is done, even if it's reloaded meanwhile
+        shared_ptr<Graph<Location>> map = store.acquire();
+        Graph<Location>* cityMap = map.get();
+
         cout << "======== ENTER INFO ========\n";
 
         
@@ -136,7 +169,7 @@ void interactMode(Graph<Location>* cityMap, char choice) {
                 } else {
                     cout << "Invalid source id! Please enter a node id present in the graph.\n";
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid source ID! Please enter a valid integer.\n";
             } 
         }
@@ -153,7 +186,7 @@ void interactMode(Graph<Location>* cityMap, char choice) {
                 } else {
                     cout << "Invalid dest id! Please enter a node id present in the graph.\n";
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid dest ID! Please enter a valid integer.\n";
             } 
         }
@@ -205,7 +238,7 @@ void interactMode(Graph<Location>* cityMap, char choice) {
                                     flag = false;
                                     break;
                                 }
-                            } catch (const invalid_argument& e) {
+                            } catch (const logic_error& e) {
                                 cout << "Invalid node ID to avoid.\n";
                                 flag = false;
                             } 
@@ -264,35 +297,53 @@ void interactMode(Graph<Location>* cityMap, char choice) {
 
                 }
 
-                int inNode;
+                vector<int> inNodes;
 
                 while (true) {
                     cout << "IncludeNode: ";
                     getline(cin, includeNode);
-        
-                    if (!includeNode.empty()) {
-                    
+                    inNodes.clear();
+
+                    // one node, or several separated by commas
+                    stringstream nodes(includeNode);
+                    bool valid = true;
+
+                    while (getline(nodes, node, ',')) {
+                        if (node.empty()) continue;
                         try {
-                            int n = stoi(includeNode);
+                            int n = stoi(node);
                             if (cityMap->findLocationId(n) != nullptr) {
-                                inNode = n;
-                                break;
+                                inNodes.push_back(n);
                             } else {
                                 cout << "Invalid node ID! Please enter a node ID present in the graph.\n";
+                                valid = false;
+                                break;
                             }
-                        } catch (const invalid_argument& e) {
+                        } catch (const logic_error& e) {
                             cout << "Invalid node ID! Please enter a valid integer.\n";
+                            valid = false;
+                            break;
                         }
-
-                    } else {
-                        inNode = -1;    // default value when user inputs nothing
-                        break;
                     }
+
+                    if (valid) break;   // no nodes is the default when user inputs nothing
+                }
+
+                bool bestOrder = false;
+
+                while (inNodes.size() > 1) {
+                    string order;
+                    cout << "WaypointOrder (fixed/best): ";
+                    getline(cin, order);
+
+                    if (order == "best") bestOrder = true;
+                    if (order.empty() || order == "fixed" || order == "best") break;
+                    cout << "Invalid order! Please enter 'fixed' or 'best'.\n";
                 }
                 
 
                 // finally...
-                route = new RestrictedRoute(cityMap, mode, source, dest, avoidNodes, avoidSegs, inNode);
+                route = new RestrictedRoute(cityMap, mode, source, dest, avoidNodes, avoidSegs, inNodes, bestOrder);
                 break;
             }
 
@@ -318,7 +369,7 @@ void interactMode(Graph<Location>* cityMap, char choice) {
                             }
                             break;  
                 
-                        } catch (const invalid_argument&) {
+                        } catch (const logic_error&) {
                             cout << "Invalid input! Please enter a valid integer.\n";
                         }
                     }
@@ -356,7 +407,7 @@ void interactMode(Graph<Location>* cityMap, char choice) {
                                     flag = false;
                                     break;
                                 }
-                            } catch (const invalid_argument& e) {
+                            } catch (const logic_error& e) {
                                 cout << "Invalid node ID to avoid.\n";
                                 flag = false;
                             } 
@@ -432,7 +483,7 @@ void interactMode(Graph<Location>* cityMap, char choice) {
 
         cout << "\nResults are here!\n\n";
         if (route) {
-            route->processRoute(cout);
+            routeCache().process(*route, cout);
             delete route; // free mem
         }
 
@@ -484,7 +535,7 @@ void interactMode(Graph<Location>* cityMap, char choice) {
 }
 
 
-void batchMode(Graph<Location>* cityMap, char choice) {       // falta fazer o controlo de erro dos nodes no batchMode
+void batchMode(MapStore &store, char choice) {       // falta fazer o controlo de erro dos nodes no batchMode
     string inputFileName, outputFileName;
     string inputFilePath, outputFilePath;
 
@@ -496,6 +547,8 @@ void batchMode(Graph<Location>* cityMap, char choice) {       // falta fazer o c
     cin >> outputFileName;
     outputFilePath = getFullPath(outputFileName);
 
+    shared_ptr<Graph<Location>> map = store.acquire();
+    Graph<Location>* cityMap = map.get();
     
     Route* route = nullptr;
 
@@ -512,6 +565,14 @@ void batchMode(Graph<Location>* cityMap, char choice) {       // falta fazer o c
             route = new EcoRoute(cityMap);
             break;
 
+        case '4':
+            route = new DistanceMatrix(cityMap);
+            break;
+
+        case '5':
+            route = new IsochroneRoute(cityMap);
+            break;
+
         default:
             cout << "\nInvalid route choice. Exiting...\n";
             exit(0);
@@ -520,11 +581,11 @@ void batchMode(Graph<Location>* cityMap, char choice) {       // falta fazer o c
     }
 
     if (route) {
-        ofstream file(outputFilePath);
         if (route->readFromFile(inputFilePath)) {
-            ofstream file(outputFilePath);
-            route->processRoute(file);
+            ofstream file(outputFilePath, getOutputFormat() == OutputFormat::Binary ? ios::out | ios::binary : ios::out);
+            routeCache().process(*route, file);
             cout << "Route calculation completed. Results saved to " << outputFileName << '\n';
+            dumpMetrics();
         } else {
             cerr << "Route calculation failed.\n\n";
         }
@@ -533,4 +594,50 @@ void batchMode(Graph<Location>* cityMap, char choice) {       // falta fazer o c
 
     
     
-}
\ No newline at end of file
+}
+
+
+
+void updateMode(MapStore &store) {
+    string fileName;
+
+    cout << "\nEnter updates file path/name: ";
+    cin >> fileName;
+
+    shared_ptr<Graph<Location>> map = store.acquire();
+    LiveMap &live = liveMap(map.get());
+    vector<WeightUpdate> updates;
+
+    if (!live.readUpdates(getFullPath(fileName), updates)) {
+        cerr << "Update failed.\n\n";
+        return;
+    }
+
+    size_t changed = live.applyUpdates(updates);
+    cout << "Updated " << changed << " edge weight(s) from " << updates.size() << " segment(s).\n\n";
+}
+
+
+void reloadMode(MapStore &store) {
+    cout << "\nReloading the city data...";
+    if (store.reload()) cout << "City map replaced.\n\n";
+    else cerr << "Reload failed.\n\n";
+}
+
+
+void metricsMode() {
+    if (dumpMetrics()) {
+        cout << "\nMetrics saved.\n\n";
+        return;
+    }
+    cout << "\n";
+    queryMetrics().writePrometheus(cout);
+    cout << "\n";
+}
+
+
+void memoryMode(MapStore &store) {
+    cout << "\n";
+    writeMemoryReport(cout, store);
+    cout << "\n";
+}
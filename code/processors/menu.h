@@ -19,6 +19,12 @@
 #include "../routes/IndependentRoute.h"
 #include "../routes/RestrictedRoute.h"
 #include "../routes/EcoRoute.h"
+#include "../routes/DistanceMatrix.h"
+#include "../routes/IsochroneRoute.h"
+#include "../routes/RouteCache.h"
+#include "../routes/LiveMap.h"
+#include "MapStore.h"
+#include "memory.h"
 #include "../data_structures/Graph.h"
 #include "../data_structures/Location.h"
 
@@ -28,33 +34,61 @@ using namespace std;
 /**
  * @brief Handles the interactive mode for route selection and processing.
  *
- * @param cityMap Pointer to the graph representing the city.
+ * @param store Holder of the current city map.
  * @param choice User's selected route type.
  */
-void interactMode(Graph<Location>* cityMap, char choice);
+void interactMode(MapStore &store, char choice);
 
 /**
  * @brief Handles the batch mode for processing routes from a file.
  *
- * @param cityMap Pointer to the graph representing the city.
+ * @param store Holder of the current city map.
  * @param choice User's selected route type.
  */
-void batchMode(Graph<Location>* cityMap, char choice);
+void batchMode(MapStore &store, char choice);
 
 /**
  * @brief Allows the user to choose between interactive and batch modes.
  *
- * @param cityMap Pointer to the graph representing the city.
+ * @param store Holder of the current city map.
  * @param choice User's selected route type.
  */
-void chooseMode(Graph<Location>* cityMap, char choice);
+void chooseMode(MapStore &store, char choice);
+
+/**
+ * @brief Applies segment time changes read from a file to the current city map.
+ *
+ * The changes are lost when the city data is reloaded.
+ *
+ * @param store Holder of the current city map.
+ */
+void updateMode(MapStore &store);
+
+/**
+ * @brief Reloads the city data and replaces the current city map.
+ *
+ * @param store Holder of the current city map.
+ */
+void reloadMode(MapStore &store);
+
+/**
+ * @brief Writes the query metrics to the metrics file, or shows them if no file was chosen.
+ */
+void metricsMode();
+
+/**
+ * @brief Shows how many bytes the current city map and the data derived from it use.
+ *
+ * @param store Holder of the current city map.
+ */
+void memoryMode(MapStore &store);
 
 /**
  * @brief Presents the user with different route planning options.
  *
- * @param cityMap Pointer to the graph representing the city.
+ * @param store Holder of the current city map.
  */
-void chooseRoute(Graph<Location>* cityMap);
+void chooseRoute(MapStore &store);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "scheduler.h"
+
+using namespace std;
+
+
+vector<size_t> scheduleBatch(const vector<Route *> &routes) {
+    vector<double> cost(routes.size(), 0);
+    vector<size_t> group(routes.size(), 0);
+
+    // group 0 holds the requests that aren't queries
+    map<string, size_t> groups;
+    vector<double> groupCost = {0};
+
+    for (size_t i = 0; i < routes.size(); i++) {
+        if (!routes[i]) continue;
+        cost[i] = routes[i]->estimateCost();
+
+        auto found = groups.emplace(routes[i]->reuseKey(), groupCost.size());
+        if (found.second) groupCost.push_back(0);
+        group[i] = found.first->second;
+        groupCost[group[i]] += cost[i];
+    }
+    groupCost[0] = -1;
+
+    vector<size_t> order(routes.size());
+    iota(order.begin(), order.end(), 0);
+
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (group[a] != group[b]) {
+            if (groupCost[group[a]] != groupCost[group[b]]) return groupCost[group[a]] > groupCost[group[b]];
+            return group[a] < group[b];
+        }
+        return cost[a] > cost[b];
+    });
+    return order;
+}
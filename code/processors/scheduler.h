@@ -0,0 +1,40 @@
+/** @file scheduler.h
+ *  @brief Contains the scheduling of the queries of a batch.
+ *
+ *  This file defines the order in which the queries of a batch are handed to the workers of a
+ *  ThreadPool, which start them in that order. The responses are still written in the order of
+ *  the input (see `serveBatch` in server.h): only the order of the work changes.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include "../routes/Route.h"
+
+using namespace std;
+
+
+/**
+ * @brief Orders the queries of a batch so the shared searches are reused and the longest work starts first.
+ *
+ * Queries with the same reuse key (see Route::reuseKey) are kept together, so the source tree and
+ * the restriction mask they share are built by the first of them and are still cached when the
+ * others run. The groups start in decreasing order of their total estimated cost, and the queries
+ * of each group in decreasing order of their own (see Route::estimateCost), so no long query is
+ * left to run alone at the end of the batch (longest processing time first). Equal costs keep the
+ * order of the input.
+ *
+ * @param routes The parsed queries of the batch, in input order (nullptr for the requests that
+ *               aren't queries, which cost nothing and go last).
+ * @return The positions of the queries in `routes`, in the order they should be started.
+ */
+vector<size_t> scheduleBatch(const vector<Route *> &routes);
+
+
+#endif
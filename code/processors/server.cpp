@@ -0,0 +1,504 @@
+#include "server.h"
+
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+
+using namespace std;
+
+
+// requests of one client processed at once before reading more of its input stops
+static const size_t MAX_PIPELINE = 64;
+
+
+// ================================= REQUESTS =================================
+
+Route *parseRequest(Graph<Location>* cityMap, const string &request, string &error) {
+    stringstream in(request);
+    string line, type, mode, body;
+    set<string> keys;
+
+    while (getline(in, line)) {
+        stringstream ss(line);
+        string key, value;
+
+        getline(ss, key, ':');
+        getline(ss, value);
+
+        while (!value.empty() && value.front() == ' ') {
+            value.erase(0, 1);
+        }
+
+        if (key == "Route") {
+            type = value;
+            continue;
+        }
+
+        if (key == "Mode") mode = value;
+        keys.insert(key);
+        body += line + '\n';
+    }
+
+    if (type.empty()) {
+        if (keys.count("Sources") || keys.count("Targets")) type = "matrix";
+        else if (keys.count("MaxTime")) type = "isochrone";
+        else if (mode == "driving-walking" || keys.count("MaxWalkTime")) type = "eco";
+        else if (keys.count("AvoidNodes") || keys.count("AvoidSegments") || keys.count("IncludeNode") || keys.count("IncludeNodes")) type = "restricted";
+        else type = "independent";
+    }
+
+    Route *route = nullptr;
+    if (type == "independent") route = new IndependentRoute(cityMap);
+    else if (type == "restricted") route = new RestrictedRoute(cityMap);
+    else if (type == "eco") route = new EcoRoute(cityMap);
+    else if (type == "matrix") route = new DistanceMatrix(cityMap);
+    else if (type == "isochrone") route = new IsochroneRoute(cityMap);
+    else {
+        error = "Unknown route type " + type + ".";
+        return nullptr;
+    }
+
+    stringstream fields(body);
+    bool valid;
+    try {valid = route->readFromStream(fields, "request");}
+    catch (const exception &e) {valid = false;}
+
+    if (!valid) {
+        delete route;
+        error = "Invalid request.";
+        return nullptr;
+    }
+
+    return route;
+}
+
+
+/**
+ * @brief Answers the requests that aren't route queries.
+ * @param store Holder of the current city map.
+ * @param request The 'Key:value' lines of the request.
+ * @param response Set to the response, if the request is one of them.
+ * @return True if the request was answered.
+ */
+static bool handleCommand(MapStore &store, const string &request, string &response) {
+    ostringstream out;
+
+    if (request == "Route:metrics\n" || request == "Route: metrics\n") queryMetrics().writePrometheus(out);
+    else if (request == "Route:memory\n" || request == "Route: memory\n") writeMemoryReport(out, store);
+    else return false;
+
+    response = out.str() + "End\n";
+    return true;
+}
+
+
+/**
+ * @brief Builds the response to a request that couldn't be answered.
+ *
+ * In the text format, it's an "Error" line followed by the "End" line. The records of the other
+ * formats delimit themselves, so it's an "error" record instead.
+ *
+ * @param error The reason why the request couldn't be answered.
+ * @return The response.
+ */
+static string errorResponse(const string &error) {
+    unique_ptr<RecordWriter> records = makeRecordWriter(getOutputFormat());
+    if (!records) return "Error:" + error + "\nEnd\n";
+
+    records->beginRecord("error");
+    records->text("message", error);
+    records->endRecord();
+    return records->data();
+}
+
+
+/**
+ * @brief Processes a parsed request.
+ *
+ * In the text format, the response ends with an "End" line. A request that is invalid, or whose
+ * processing fails, gets an error response (see errorResponse).
+ *
+ * @param route The route of the request (deleted here), or nullptr if it was invalid.
+ * @param error The reason why the request was invalid.
+ * @return The response.
+ */
+static string respond(Route *route, const string &error) {
+    if (!route) return errorResponse(error);
+
+    ostringstream out;
+    try {routeCache().process(*route, out);}
+    catch (const exception &e) {
+        delete route;
+        return errorResponse(string("Request failed: ") + e.what());
+    }
+    delete route;
+
+    string response = out.str();
+    if (getOutputFormat() != OutputFormat::Text) return response;
+    if (!response.empty() && response.back() != '\n') response += '\n';
+    return response + "End\n";
+}
+
+
+string handleRequest(MapStore &store, const string &request) {
+    try {
+        string response;
+        if (handleCommand(store, request, response)) return response;
+
+        // the map stays alive until this request is done, even if it's reloaded meanwhile
+        shared_ptr<Graph<Location>> map = store.acquire();
+
+        string error;
+        Route *route = parseRequest(map.get(), request, error);
+        return respond(route, error);
+    } catch (const exception &e) {
+        return errorResponse(string("Request failed: ") + e.what());
+    }
+}
+
+
+/**
+ * @brief Splits a stream of bytes into requests separated by empty lines.
+ */
+struct RequestFramer {
+    string partial;     ///< Start of a line whose end wasn't received yet.
+    string current;     ///< Lines of the request being received.
+
+    /**
+     * @brief Consumes received bytes.
+     * @param data The bytes.
+     * @param size Number of bytes.
+     * @param requests Vector where the completed requests are appended.
+     */
+    void feed(const char *data, size_t size, vector<string> &requests) {
+        partial.append(data, size);
+
+        size_t start = 0, eol;
+        while ((eol = partial.find('\n', start)) != string::npos) {
+            line(partial.substr(start, eol - start), requests);
+            start = eol + 1;
+        }
+        partial.erase(0, start);
+    }
+
+    /**
+     * @brief Handles the end of the input, completing the last request.
+     * @param requests Vector where the completed request is appended.
+     */
+    void finish(vector<string> &requests) {
+        if (!partial.empty()) line(partial, requests);
+        partial.clear();
+        if (!current.empty()) requests.push_back(move(current));
+        current.clear();
+    }
+
+    /**
+     * @brief Handles one complete line.
+     */
+    void line(string text, vector<string> &requests) {
+        if (!text.empty() && text.back() == '\r') text.pop_back();
+
+        if (!text.empty()) current += text + '\n';
+        else if (!current.empty()) {
+            requests.push_back(move(current));
+            current.clear();
+        }
+    }
+};
+
+
+
+
+// ================================= STREAM =================================
+
+int serveStream(MapStore &store, istream &in, ostream &out, unsigned threads) {
+    // responses in the order of the requests
+    BlockWriter writer(out);
+    ThreadPool pool(threads);
+
+    auto submit = [&](string request) {
+        auto task = make_shared<packaged_task<string()>>([&store, request] { return handleRequest(store, request); });
+        writer.push(task->get_future());
+        pool.submit([task] { (*task)(); });
+    };
+
+    RequestFramer framer;
+    vector<string> requests;
+    string line;
+
+    while (getline(in, line)) {
+        line += '\n';
+        framer.feed(line.data(), line.size(), requests);
+        for (auto &r : requests) submit(move(r));
+        requests.clear();
+    }
+    framer.finish(requests);
+    for (auto &r : requests) submit(move(r));
+
+    writer.finish();
+    dumpMetrics();
+    return 0;
+}
+
+
+
+
+// ================================= BATCH =================================
+
+int serveBatch(MapStore &store, istream &in, ostream &out, unsigned threads) {
+    RequestFramer framer;
+    vector<string> requests;
+    string line;
+
+    while (getline(in, line)) {
+        line += '\n';
+        framer.feed(line.data(), line.size(), requests);
+    }
+    framer.finish(requests);
+
+    // the whole batch runs on the same map, even if it's reloaded meanwhile
+    shared_ptr<Graph<Location>> map = store.acquire();
+
+    vector<Route *> routes(requests.size(), nullptr);
+    vector<string> errors(requests.size());
+    vector<bool> commands(requests.size(), false);
+    vector<promise<string>> responses(requests.size());
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        string response;
+        if (handleCommand(store, requests[i], response)) {
+            commands[i] = true;
+            responses[i].set_value(response);
+        }
+        else routes[i] = parseRequest(map.get(), requests[i], errors[i]);
+    }
+
+    {
+        // in the order of the requests, as soon as each one is done
+        BlockWriter writer(out);
+        for (auto &response : responses) writer.push(response.get_future());
+
+        ThreadPool pool(threads);
+
+        for (size_t i : scheduleBatch(routes)) {
+            if (commands[i]) continue;
+            pool.submit([&, i] {
+                try {responses[i].set_value(respond(routes[i], errors[i]));}
+                catch (...) {responses[i].set_exception(current_exception());}
+            });
+        }
+    }
+
+    dumpMetrics();
+    return 0;
+}
+
+
+
+
+// ================================= SOCKET =================================
+
+// written by the signal handler to wake the event loop up
+static int wakeFd = -1;
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int) {
+    interrupted = 1;
+    char c = 0;
+    if (write(wakeFd, &c, 1) < 0) {}    // nothing else can be done in a handler
+}
+
+
+/**
+ * @brief State of a client of the socket server.
+ */
+struct Client {
+    int fd;                             ///< Socket of the client.
+    RequestFramer framer;               ///< Requests being received.
+    unsigned long nextSeq = 0;          ///< Number of requests received.
+    unsigned long nextWrite = 0;        ///< Number of responses queued for sending.
+    map<unsigned long, string> done;    ///< Finished responses that can't be sent yet, by request.
+    string outBuf;                      ///< Bytes waiting to be sent.
+    bool readClosed = false;            ///< True after the client stopped sending.
+};
+
+
+/**
+ * @brief A response finished by a worker.
+ */
+struct Finished {
+    unsigned long client;       ///< ID of the client.
+    unsigned long seq;          ///< Number of the request of the client.
+    string response;            ///< The response.
+};
+
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+
+int serveSocket(MapStore &store, const string &path, unsigned threads) {
+
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Socket path too long: " << path << "\n";
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (listenFd == -1 || bind(listenFd, (sockaddr *) &addr, sizeof(addr)) == -1 || listen(listenFd, SOMAXCONN) == -1 || !setNonBlocking(listenFd)) {
+        cerr << "Couldn't listen on " << path << ": " << strerror(errno) << "\n";
+        if (listenFd != -1) close(listenFd);
+        return 1;
+    }
+
+    int wake[2];
+    if (pipe(wake) == -1) {
+        cerr << "Couldn't create the wake-up pipe: " << strerror(errno) << "\n";
+        close(listenFd);
+        return 1;
+    }
+    setNonBlocking(wake[0]);
+    setNonBlocking(wake[1]);
+    wakeFd = wake[1];
+
+    interrupted = 0;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    cout << "Serving on " << path << ". Press Ctrl+C to stop.\n" << flush;
+
+    map<unsigned long, Client> clients;
+    unsigned long nextClient = 0;
+
+    // responses finished by the workers, waiting for the event loop
+    vector<Finished> finished;
+    mutex finishedLock;
+
+    {
+        ThreadPool pool(threads);
+
+        auto dispatch = [&](unsigned long id, Client &c, string request) {
+            unsigned long seq = c.nextSeq++;
+            pool.submit([&, id, seq, request] {
+                string response = handleRequest(store, request);
+                {
+                    lock_guard<mutex> guard(finishedLock);
+                    finished.push_back({id, seq, move(response)});
+                }
+                char b = 1;
+                if (write(wake[1], &b, 1) < 0) {}     // pipe full: the loop is being woken up anyway
+            });
+        };
+
+        vector<pollfd> fds;
+        vector<unsigned long> ids;
+
+        while (!interrupted) {
+            fds.assign({{listenFd, POLLIN, 0}, {wake[0], POLLIN, 0}});
+            ids.clear();
+            for (auto &[id, c] : clients) {
+                short events = 0;
+                if (!c.readClosed && c.nextSeq - c.nextWrite < MAX_PIPELINE) events |= POLLIN;
+                if (!c.outBuf.empty()) events |= POLLOUT;
+                fds.push_back({c.fd, events, 0});
+                ids.push_back(id);
+            }
+
+            if (poll(fds.data(), fds.size(), -1) == -1) {
+                if (errno == EINTR) continue;
+                cerr << "poll failed: " << strerror(errno) << "\n";
+                break;
+            }
+
+            // new clients
+            if (fds[0].revents & POLLIN) {
+                int fd;
+                while ((fd = accept(listenFd, nullptr, nullptr)) != -1) {
+                    setNonBlocking(fd);
+                    clients[nextClient++].fd = fd;
+                }
+            }
+
+            // finished responses, queued in request order
+            if (fds[1].revents & POLLIN) {
+                char drain[256];
+                while (read(wake[0], drain, sizeof(drain)) > 0) {}
+
+                vector<Finished> batch;
+                {
+                    lock_guard<mutex> guard(finishedLock);
+                    batch.swap(finished);
+                }
+                for (auto &f : batch) {
+                    auto it = clients.find(f.client);
+                    if (it == clients.end()) continue;      // client already gone
+                    Client &c = it->second;
+                    c.done[f.seq] = move(f.response);
+                    for (auto d = c.done.find(c.nextWrite); d != c.done.end(); d = c.done.find(c.nextWrite)) {
+                        c.outBuf += d->second;
+                        c.done.erase(d);
+                        c.nextWrite++;
+                    }
+                }
+            }
+
+            for (size_t i = 2; i < fds.size(); i++) {
+                auto it = clients.find(ids[i - 2]);
+                if (it == clients.end()) continue;
+                Client &c = it->second;
+                bool drop = fds[i].revents & (POLLERR | POLLNVAL);
+
+                if (!drop && (fds[i].revents & (POLLIN | POLLHUP))) {
+                    char buf[4096];
+                    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+                    vector<string> requests;
+
+                    if (n > 0) c.framer.feed(buf, n, requests);
+                    else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        c.framer.finish(requests);
+                        c.readClosed = true;
+                    }
+                    for (auto &r : requests) dispatch(it->first, c, move(r));
+                }
+
+                if (!drop && !c.outBuf.empty() && (fds[i].revents & POLLOUT)) {
+                    ssize_t n = send(c.fd, c.outBuf.data(), c.outBuf.size(), MSG_NOSIGNAL);
+                    if (n > 0) c.outBuf.erase(0, n);
+                    else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) drop = true;
+                }
+
+                // done once it stopped sending and got every response
+                if (drop || (c.readClosed && c.nextWrite == c.nextSeq && c.outBuf.empty())) {
+                    close(c.fd);
+                    clients.erase(it);
+                }
+            }
+        }
+
+        cout << "\nStopping the server...\n";
+    }   // waits for the requests still running
+
+    for (auto &[id, c] : clients) close(c.fd);
+    close(listenFd);
+    unlink(path.c_str());
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    wakeFd = -1;
+    close(wake[0]);
+    close(wake[1]);
+    dumpMetrics();
+    return 0;
+}
@@ -0,0 +1,109 @@
+/** @file server.h
+ *  @brief Contains the functions of the routing server mode.
+ *
+ *  This file defines a long-running mode that loads the city map once and answers route
+ *  requests from many clients, over a Unix domain socket or over the standard input and output.
+ *
+ *  A request is a block of 'Key:value' lines with the same keys as the input files, ended by an
+ *  empty line (or by the end of the input). The type of route can be given with a 'Route' key 
+ *  (independent, restricted, eco, matrix or isochrone); otherwise it is deduced from the other keys.
+ *  Each response is the same text written in batch mode, followed by a line with just "End", or,
+ *  with another output format, the record of the route, or an "error" record (see writer.h).
+ *  A request with just 'Route:metrics' is answered with the query metrics in the Prometheus text format,
+ *  and one with just 'Route:memory' with the memory report (see memory.h).
+ *  Clients may send several requests without waiting for the responses (pipelining): requests 
+ *  are processed concurrently, and the responses of a client come back in the order of its requests.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <map>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+
+#include "MapStore.h"
+#include "ThreadPool.h"
+#include "scheduler.h"
+#include "writer.h"
+#include "memory.h"
+#include "../routes/IndependentRoute.h"
+#include "../routes/RestrictedRoute.h"
+#include "../routes/EcoRoute.h"
+#include "../routes/DistanceMatrix.h"
+#include "../routes/IsochroneRoute.h"
+#include "../routes/RouteCache.h"
+#include "../routes/QueryMetrics.h"
+
+using namespace std;
+
+
+/**
+ * @brief Builds the route of a server request.
+ *
+ * @param cityMap Pointer to the graph representing the city.
+ * @param request The 'Key:value' lines of the request.
+ * @param error Set to the reason of the failure, if any.
+ * @return The route (to be deleted by the caller), or nullptr if the request is invalid.
+ */
+Route *parseRequest(Graph<Location>* cityMap, const string &request, string &error);
+
+/**
+ * @brief Answers a server request on the current city map.
+ *
+ * Doesn't throw: a request that can't be answered gets an error response.
+ *
+ * @param store Holder of the current city map.
+ * @param request The 'Key:value' lines of the request.
+ * @return The response, including the final "End" line.
+ */
+string handleRequest(MapStore &store, const string &request);
+
+/**
+ * @brief Serves the requests read from a stream until its end.
+ *
+ * @param store Holder of the current city map.
+ * @param in The stream of requests (e.g. std::cin).
+ * @param out The stream where the responses are written, in order (e.g. std::cout).
+ * @param threads Number of requests processed at once (0 uses the hardware concurrency).
+ * @return 0 when the input ends. The metrics are dumped then (see QueryMetrics).
+ */
+int serveStream(MapStore &store, istream &in, ostream &out, unsigned threads = 0);
+
+/**
+ * @brief Serves a whole batch of requests read from a stream, scheduled before they run.
+ *
+ * Unlike `serveStream`, every request is read and parsed before any of them runs, so they can 
+ * be started in the order chosen by `scheduleBatch` (grouped by the searches they share, the 
+ * longest first). The responses are written in the order of the requests, and the commands 
+ * ('Route:metrics', 'Route:memory') are answered when they are read.
+ *
+ * @param store Holder of the current city map.
+ * @param in The stream of requests (e.g. std::cin), read until its end.
+ * @param out The stream where the responses are written, in order (e.g. std::cout).
+ * @param threads Number of requests processed at once (0 uses the hardware concurrency).
+ * @return 0 when every request is answered. The metrics are dumped then (see QueryMetrics).
+ */
+int serveBatch(MapStore &store, istream &in, ostream &out, unsigned threads = 0);
+
+/**
+ * @brief Serves clients over a Unix domain socket until interrupted (SIGINT or SIGTERM).
+ *
+ * @param store Holder of the current city map.
+ * @param path Path of the socket. An existing file at that path is replaced.
+ * @param threads Number of requests processed at once (0 uses the hardware concurrency).
+ * @return 0 after a clean shutdown, 1 if the socket couldn't be set up. The metrics are dumped
+ * at shutdown (see QueryMetrics).
+ */
+int serveSocket(MapStore &store, const string &path, unsigned threads = 0);
+
+
+#endif
@@ -0,0 +1,138 @@
+#include "trace.h"
+
+#include <iostream>
+
+using namespace std;
+
+
+#ifdef DA_TRACE
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+
+/**
+ * @brief A recorded event.
+ */
+struct TraceEvent {
+    const char *name;       ///< Name of the event.
+    const char *category;   ///< Category of the event.
+    double start;           ///< Start in microseconds since tracing started.
+    double duration;        ///< Duration in microseconds.
+};
+
+/**
+ * @brief The events recorded by one thread.
+ */
+struct TraceBuffer {
+    int tid;                    ///< Number of the thread in the trace.
+    mutex lock;                 ///< Only contended while the trace is written.
+    vector<TraceEvent> events;  ///< The events.
+};
+
+/**
+ * @brief State shared by all threads.
+ */
+struct TraceState {
+    atomic<bool> active{false};                 ///< True once tracing started.
+    chrono::steady_clock::time_point origin;    ///< Time zero of the trace.
+    string filename;                            ///< File where the trace is written.
+    mutex lock;                                 ///< Protects `buffers`.
+    vector<shared_ptr<TraceBuffer>> buffers;    ///< Buffers of every thread, kept after the threads end.
+};
+
+static TraceState &traceState() {
+    static TraceState state;
+    return state;
+}
+
+static double now() {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - traceState().origin).count();
+}
+
+static TraceBuffer &threadBuffer() {
+    thread_local shared_ptr<TraceBuffer> buffer;
+    if (!buffer) {
+        TraceState &state = traceState();
+        lock_guard<mutex> guard(state.lock);
+        buffer = make_shared<TraceBuffer>();
+        buffer->tid = state.buffers.size() + 1;
+        state.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+
+TraceScope::TraceScope(const char *name, const char *category)
+    : name(name), category(category), start(traceState().active ? now() : -1) {}
+
+
+TraceScope::~TraceScope() {
+    if (start < 0) return;
+
+    double end = now();
+    TraceBuffer &buffer = threadBuffer();
+    lock_guard<mutex> guard(buffer.lock);
+    buffer.events.push_back({name, category, start, end - start});
+}
+
+
+bool startTrace(const string &filename) {
+    TraceState &state = traceState();
+    {
+        lock_guard<mutex> guard(state.lock);
+        state.filename = filename;
+        state.origin = chrono::steady_clock::now();
+    }
+
+    // registered after the state exists, so it runs before the state is destroyed
+    static bool registered = false;
+    if (!registered) {
+        atexit(writeTrace);
+        registered = true;
+    }
+
+    state.active = true;
+    return true;
+}
+
+
+void writeTrace() {
+    TraceState &state = traceState();
+    if (!state.active) return;
+
+    lock_guard<mutex> guard(state.lock);
+    ofstream out(state.filename);
+    if (!out) {
+        cerr << "Couldn't write the trace file " << state.filename << "\n";
+        return;
+    }
+
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (auto &buffer : state.buffers) {
+        lock_guard<mutex> bufferGuard(buffer->lock);
+        for (auto &e : buffer->events) {
+            if (!first) out << ",\n";
+            first = false;
+            out << "{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << fixed << e.start << ",\"dur\":" << e.duration << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+#else
+
+bool startTrace(const string &filename) {
+    cerr << "Tracing isn't compiled in (configure with -DDA_TRACE=ON), not writing " << filename << "\n";
+    return false;
+}
+
+void writeTrace() {}
+
+#endif
@@ -0,0 +1,80 @@
+/** @file trace.h
+ *  @brief Contains scoped tracing in the Chrome trace-event format.
+ *
+ *  `TRACE_SCOPE(name, category)` records the time spent in the enclosing scope as a complete
+ *  event. The events of all threads are written as a JSON file that can be opened in a trace
+ *  viewer (chrome://tracing or Perfetto).
+ *
+ *  Tracing is only compiled in when `DA_TRACE` is defined (the DA_TRACE option of CMake). 
+ *  Otherwise `TRACE_SCOPE` expands to nothing, so it costs nothing. When compiled in, events 
+ *  are only recorded after `startTrace` is called.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+
+
+#ifdef DA_TRACE
+
+/**
+ * @class TraceScope
+ * @brief Records a complete trace event covering its lifetime.
+ *
+ * Each thread appends its events to a buffer of its own, so threads don't contend for a lock.
+ */
+class TraceScope {
+    public:
+        /**
+         * @brief Starts the event.
+         * @param name Name of the event (must be a string literal).
+         * @param category Category of the event (must be a string literal).
+         */
+        TraceScope(const char *name, const char *category);
+
+        /**
+         * @brief Ends the event and records it, if tracing was started.
+         */
+        ~TraceScope();
+
+        TraceScope(const TraceScope &) = delete;
+        TraceScope &operator=(const TraceScope &) = delete;
+
+    private:
+        const char *name;       ///< Name of the event
+        const char *category;   ///< Category of the event
+        double start;           ///< Start of the event in microseconds, or negative if not tracing
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/// Records the time spent in the enclosing scope.
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category)
+
+#else
+
+/// Tracing is compiled out.
+#define TRACE_SCOPE(name, category) ((void) 0)
+
+#endif
+
+
+/**
+ * @brief Starts recording trace events. They are written to the file at exit or by `writeTrace`.
+ *
+ * @param filename The name of the JSON file to write.
+ * @return True if tracing started, false if it isn't compiled in.
+ */
+bool startTrace(const std::string &filename);
+
+/**
+ * @brief Writes every event recorded so far to the trace file.
+ *
+ * Does nothing if tracing wasn't started.
+ */
+void writeTrace();
+
+
+#endif
@@ -0,0 +1,317 @@
+#include "writer.h"
+#include "../data_structures/Graph.h"
+
+using namespace std;
+
+
+static atomic<OutputFormat> outputFormat{OutputFormat::Text};
+
+
+bool setOutputFormat(const string &name) {
+    if (name == "text") outputFormat = OutputFormat::Text;
+    else if (name == "jsonl") outputFormat = OutputFormat::JSONL;
+    else if (name == "binary") outputFormat = OutputFormat::Binary;
+    else {
+        cerr << "Unknown output format " << name << " (expected text, jsonl or binary)\n";
+        return false;
+    }
+    return true;
+}
+
+
+OutputFormat getOutputFormat() {
+    return outputFormat;
+}
+
+
+const char *outputFormatName() {
+    switch (outputFormat.load()) {
+        case OutputFormat::JSONL: return "jsonl";
+        case OutputFormat::Binary: return "binary";
+        default: return "text";
+    }
+}
+
+
+void writeIds(ostream &out, const vector<int> &ids) {
+    string line;
+    line.reserve(ids.size() * 6);
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (i > 0) line += ',';
+        appendInt(line, ids[i]);
+    }
+    out.write(line.data(), line.size());
+}
+
+
+
+
+// ================================= RECORDS =================================
+
+void RecordWriter::time(const char *name, double value) {
+    if (value >= INF) none(name);
+    else number(name, (long long) value);
+}
+
+
+unique_ptr<RecordWriter> makeRecordWriter(OutputFormat format) {
+    if (format == OutputFormat::JSONL) return make_unique<JsonRecordWriter>();
+    if (format == OutputFormat::Binary) return make_unique<BinaryRecordWriter>();
+    return nullptr;
+}
+
+
+void JsonRecordWriter::key(const char *name) {
+    if (!first.back()) buffer += ',';
+    first.back() = false;
+    if (!name) return;
+    buffer += '"';
+    buffer += name;
+    buffer += "\":";
+}
+
+
+void JsonRecordWriter::quoted(const string &value) {
+    buffer += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            buffer += '\\';
+            buffer += c;
+        }
+        else if (c == '\n') buffer += "\\n";
+        else if ((unsigned char) c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            buffer += escape;
+        }
+        else buffer += c;
+    }
+    buffer += '"';
+}
+
+
+void JsonRecordWriter::beginRecord(const char *type) {
+    buffer += '{';
+    first.assign(1, true);
+    text("type", type);
+}
+
+
+void JsonRecordWriter::endRecord() {
+    buffer += "}\n";
+    first.clear();
+}
+
+
+void JsonRecordWriter::number(const char *name, long long value) {
+    key(name);
+    appendInt(buffer, value);
+}
+
+
+void JsonRecordWriter::none(const char *name) {
+    key(name);
+    buffer += "null";
+}
+
+
+void JsonRecordWriter::text(const char *name, const string &value) {
+    key(name);
+    quoted(value);
+}
+
+
+void JsonRecordWriter::path(const char *name, const vector<int> &ids) {
+    key(name);
+    buffer += '[';
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (i > 0) buffer += ',';
+        appendInt(buffer, ids[i]);
+    }
+    buffer += ']';
+}
+
+
+void JsonRecordWriter::beginList(const char *name) {
+    key(name);
+    buffer += '[';
+    first.push_back(true);
+}
+
+
+void JsonRecordWriter::endList() {
+    buffer += ']';
+    first.pop_back();
+}
+
+
+void JsonRecordWriter::beginItem() {
+    key(nullptr);
+    buffer += '{';
+    first.push_back(true);
+}
+
+
+void JsonRecordWriter::endItem() {
+    buffer += '}';
+    first.pop_back();
+}
+
+
+void BinaryRecordWriter::varint(unsigned long long value) {
+    while (value >= 0x80) {
+        record += (char) (value | 0x80);
+        value >>= 7;
+    }
+    record += (char) value;
+}
+
+
+void BinaryRecordWriter::zigzag(long long value) {
+    varint(((unsigned long long) value << 1) ^ (unsigned long long) (value >> 63));
+}
+
+
+void BinaryRecordWriter::beginRecord(const char *type) {
+    record.clear();
+    string name = type;
+    varint(name.size());
+    record += name;
+}
+
+
+void BinaryRecordWriter::endRecord() {
+    // the length goes before the bytes of the record
+    string bytes = move(record);
+    record.clear();
+    varint(bytes.size());
+    buffer += record;
+    buffer += bytes;
+    record.clear();
+}
+
+
+void BinaryRecordWriter::number(const char *, long long value) {
+    record += BINARY_NUMBER;
+    zigzag(value);
+}
+
+
+void BinaryRecordWriter::none(const char *) {
+    record += BINARY_NONE;
+}
+
+
+void BinaryRecordWriter::text(const char *, const string &value) {
+    record += BINARY_TEXT;
+    varint(value.size());
+    record += value;
+}
+
+
+void BinaryRecordWriter::path(const char *, const vector<int> &ids) {
+    record += BINARY_PATH;
+    varint(ids.size());
+    long long previous = 0;
+    for (int id : ids) {
+        zigzag(id - previous);
+        previous = id;
+    }
+}
+
+
+void BinaryRecordWriter::beginList(const char *) {
+    record += BINARY_LIST;
+}
+
+
+void BinaryRecordWriter::endList() {
+    record += BINARY_END;
+}
+
+
+void BinaryRecordWriter::beginItem() {
+    record += BINARY_ITEM;
+}
+
+
+void BinaryRecordWriter::endItem() {
+    record += BINARY_END;
+}
+
+
+
+
+// ================================= BLOCKS =================================
+
+BlockWriter::BlockWriter(ostream &out) : out(out) {
+    worker = thread(&BlockWriter::run, this);
+}
+
+
+BlockWriter::~BlockWriter() {
+    finish();
+}
+
+
+void BlockWriter::push(future<string> result) {
+    {
+        lock_guard<mutex> guard(lock);
+        pending.push_back(move(result));
+    }
+    ready.notify_one();
+}
+
+
+void BlockWriter::push(string result) {
+    promise<string> known;
+    known.set_value(move(result));
+    push(known.get_future());
+}
+
+
+void BlockWriter::finish() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (done && !worker.joinable()) return;
+        done = true;
+    }
+    ready.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+
+void BlockWriter::run() {
+    string block;
+    block.reserve(BLOCK_SIZE);
+
+    auto flushBlock = [&]() {
+        if (block.empty()) return;
+        out.write(block.data(), block.size());
+        out.flush();
+        block.clear();
+    };
+
+    while (true) {
+        future<string> next;
+        {
+            unique_lock<mutex> guard(lock);
+            if (pending.empty()) {
+                // nothing queued: whoever waits for the results so far gets them now
+                guard.unlock();
+                flushBlock();
+                guard.lock();
+            }
+            ready.wait(guard, [&] { return done || !pending.empty(); });
+            if (pending.empty()) break;
+            next = move(pending.front());
+            pending.pop_front();
+        }
+
+        if (next.wait_for(chrono::seconds(0)) != future_status::ready) flushBlock();
+        block += next.get();
+        if (block.size() >= BLOCK_SIZE) flushBlock();
+    }
+
+    flushBlock();
+}
@@ -0,0 +1,326 @@
+/** @file writer.h
+ *  @brief Contains the formats in which the results of the routes are written.
+ *
+ *  Besides the text format of the input files, the results can be written as JSON Lines (one JSON
+ *  object per result) or in a compact binary format, both produced by a RecordWriter from the fields
+ *  each route writes in `Route::writeRecord`. Integers are formatted with `to_chars` into a buffer
+ *  that is written at once, instead of element by element through an ostream.
+ *
+ *  The binary format is a sequence of records, each one the varint length of its bytes followed by
+ *  the varint length and the characters of its type (e.g. "independent") and then its fields, in
+ *  the order of the keys of the JSON records, each one a tag byte and its value:
+ *
+ *  - BINARY_NUMBER: a zigzag varint;
+ *  - BINARY_NONE: nothing (no route, unreachable, no parking node...);
+ *  - BINARY_TEXT: the varint length and the bytes of the text;
+ *  - BINARY_PATH: the varint number of IDs, the zigzag varint of the first one and then the zigzag
+ *    varint of the difference of each one from the previous one (neighbouring locations have close IDs);
+ *  - BINARY_LIST / BINARY_ITEM: the fields of a list or of one of its items, until BINARY_END.
+ *
+ *  Varints are little-endian base 128 (7 bits per byte, the highest bit set on all bytes but the last).
+ */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <charconv>
+#include <iostream>
+#include <condition_variable>
+
+using namespace std;
+
+
+/**
+ * @brief Format of the results of the routes.
+ */
+enum class OutputFormat {
+    Text,   ///< 'Key:value' lines, as in the input files (the default).
+    JSONL,  ///< One JSON object per line.
+    Binary  ///< Length-prefixed records with varint-delta paths (see writer.h).
+};
+
+
+/**
+ * @brief Chooses the format of the results written from now on.
+ * @param name "text", "jsonl" or "binary".
+ * @return True if the name is valid, false otherwise.
+ */
+bool setOutputFormat(const string &name);
+
+/**
+ * @brief Gets the format of the results.
+ * @return The format chosen with `setOutputFormat`.
+ */
+OutputFormat getOutputFormat();
+
+/**
+ * @brief Gets the name of the format of the results.
+ * @return "text", "jsonl" or "binary".
+ */
+const char *outputFormatName();
+
+
+/**
+ * @brief Appends an integer to a buffer in decimal.
+ * @param out The buffer.
+ * @param value The integer.
+ */
+inline void appendInt(string &out, long long value) {
+    char digits[24];
+    auto res = to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, res.ptr);
+}
+
+/**
+ * @brief Writes location IDs separated by commas, in one write.
+ * @param out The stream.
+ * @param ids The IDs.
+ */
+void writeIds(ostream &out, const vector<int> &ids);
+
+
+/**
+ * @class RecordWriter
+ * @brief Formats the results of routes as records of named fields.
+ *
+ * A record holds numbers, missing values, texts, paths and lists, whose elements are either
+ * values (written with a null name) or items with fields of their own.
+ */
+class RecordWriter {
+
+    public:
+        virtual ~RecordWriter() = default;
+
+        /**
+         * @brief Starts a record.
+         * @param type The type of the record (e.g. "independent").
+         */
+        virtual void beginRecord(const char *type) = 0;
+
+        /**
+         * @brief Ends the record.
+         */
+        virtual void endRecord() = 0;
+
+        /**
+         * @brief Writes a number.
+         * @param name The name of the field (nullptr inside a list).
+         * @param value The number.
+         */
+        virtual void number(const char *name, long long value) = 0;
+
+        /**
+         * @brief Writes a missing value.
+         * @param name The name of the field (nullptr inside a list).
+         */
+        virtual void none(const char *name) = 0;
+
+        /**
+         * @brief Writes a text.
+         * @param name The name of the field (nullptr inside a list).
+         * @param value The text.
+         */
+        virtual void text(const char *name, const string &value) = 0;
+
+        /**
+         * @brief Writes a sequence of location IDs.
+         * @param name The name of the field (nullptr inside a list).
+         * @param ids The IDs (empty if there is no path).
+         */
+        virtual void path(const char *name, const vector<int> &ids) = 0;
+
+        /**
+         * @brief Starts a list.
+         * @param name The name of the field.
+         */
+        virtual void beginList(const char *name) = 0;
+
+        /**
+         * @brief Ends the list.
+         */
+        virtual void endList() = 0;
+
+        /**
+         * @brief Starts an item of a list, with fields of its own.
+         */
+        virtual void beginItem() = 0;
+
+        /**
+         * @brief Ends the item.
+         */
+        virtual void endItem() = 0;
+
+        /**
+         * @brief Writes a time, or a missing value if it's INF.
+         * @param name The name of the field (nullptr inside a list).
+         * @param value The time.
+         */
+        void time(const char *name, double value);
+
+        /**
+         * @brief Gets the bytes formatted so far.
+         * @return The formatted records.
+         */
+        const string &data() const { return buffer; }
+
+    protected:
+        string buffer;      ///< The formatted records
+};
+
+
+/**
+ * @class JsonRecordWriter
+ * @brief Writes each record as a JSON object on a line of its own.
+ */
+class JsonRecordWriter : public RecordWriter {
+
+    public:
+        void beginRecord(const char *type) override;
+        void endRecord() override;
+        void number(const char *name, long long value) override;
+        void none(const char *name) override;
+        void text(const char *name, const string &value) override;
+        void path(const char *name, const vector<int> &ids) override;
+        void beginList(const char *name) override;
+        void endList() override;
+        void beginItem() override;
+        void endItem() override;
+
+    private:
+        vector<bool> first;     ///< For each open object or list, true until it gets an element
+
+        /**
+         * @brief Writes the separator and the key of the next element.
+         * @param name The key (nullptr inside a list).
+         */
+        void key(const char *name);
+
+        /**
+         * @brief Writes a string with the JSON escapes.
+         * @param value The string.
+         */
+        void quoted(const string &value);
+};
+
+
+const char BINARY_NUMBER = 1;   ///< Tag of a number in the binary format.
+const char BINARY_NONE = 2;     ///< Tag of a missing value in the binary format.
+const char BINARY_TEXT = 3;     ///< Tag of a text in the binary format.
+const char BINARY_PATH = 4;     ///< Tag of a path in the binary format.
+const char BINARY_LIST = 5;     ///< Tag of the start of a list in the binary format.
+const char BINARY_ITEM = 6;     ///< Tag of the start of an item in the binary format.
+const char BINARY_END = 7;      ///< Tag of the end of a list or an item in the binary format.
+
+
+/**
+ * @class BinaryRecordWriter
+ * @brief Writes each record in the binary format described in writer.h.
+ */
+class BinaryRecordWriter : public RecordWriter {
+
+    public:
+        void beginRecord(const char *type) override;
+        void endRecord() override;
+        void number(const char *name, long long value) override;
+        void none(const char *name) override;
+        void text(const char *name, const string &value) override;
+        void path(const char *name, const vector<int> &ids) override;
+        void beginList(const char *name) override;
+        void endList() override;
+        void beginItem() override;
+        void endItem() override;
+
+    private:
+        string record;      ///< The record being written, prefixed with its length when it ends
+
+        /**
+         * @brief Appends an unsigned varint to the record.
+         * @param value The value.
+         */
+        void varint(unsigned long long value);
+
+        /**
+         * @brief Appends a signed value to the record as a zigzag varint.
+         * @param value The value.
+         */
+        void zigzag(long long value);
+};
+
+
+/**
+ * @brief Makes a writer of records in a format.
+ * @param format JSONL or Binary.
+ * @return The writer, or nullptr for the text format.
+ */
+unique_ptr<RecordWriter> makeRecordWriter(OutputFormat format);
+
+
+/**
+ * @class BlockWriter
+ * @brief Writes results to a stream in large blocks, on a thread of its own.
+ *
+ * Results are queued as futures, in the order they must be written, while they're still being
+ * computed. The writer thread waits for each one in turn and appends it to a block, which is
+ * written and flushed when it's full or when the next result isn't ready yet, so a reader waiting
+ * for a response isn't kept waiting for the block to fill up.
+ */
+class BlockWriter {
+
+    public:
+        static const size_t BLOCK_SIZE = 1 << 20;   ///< Bytes gathered before a write.
+
+        /**
+         * @brief Starts the writer thread.
+         * @param out The stream (must outlive the writer).
+         */
+        explicit BlockWriter(ostream &out);
+
+        /**
+         * @brief Writes the remaining results and stops the writer thread.
+         */
+        ~BlockWriter();
+
+        BlockWriter(const BlockWriter &) = delete;
+        BlockWriter &operator=(const BlockWriter &) = delete;
+
+        /**
+         * @brief Queues a result, written after the results queued before it.
+         * @param result The result, possibly still being computed.
+         */
+        void push(future<string> result);
+
+        /**
+         * @brief Queues a result that is already known.
+         * @param result The result.
+         */
+        void push(string result);
+
+        /**
+         * @brief Waits until every queued result is written, then stops the writer thread.
+         */
+        void finish();
+
+    private:
+        ostream &out;                       ///< The stream
+        deque<future<string>> pending;      ///< Results not written yet, in order
+        mutex lock;                         ///< Protects `pending` and `done`
+        condition_variable ready;           ///< Signals new results or the end
+        bool done = false;                  ///< Set when no more results will be queued
+        thread worker;                      ///< The writer thread
+
+        /**
+         * @brief Body of the writer thread.
+         */
+        void run();
+};
+
+
+#endif
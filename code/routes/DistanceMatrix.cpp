@@ -0,0 +1,255 @@
+#include "DistanceMatrix.h"
+
+using namespace std;
+
+
+bool DistanceMatrix::parseIds(const string &value, vector<int> &ids) {
+    stringstream nodes(value);
+    string node;
+
+    while (getline(nodes, node, ',')) {
+        if (node.empty()) continue;
+        try {
+            int id = stoi(node);
+            if (cityMap->findLocationId(id) == nullptr) {
+                cout << "Invalid ID " << id << "! Please enter IDs present in the graph.\n";
+                return false;
+            }
+            ids.push_back(id);
+        } catch (const logic_error& e) {
+            cout << "Invalid node ID! Please enter a valid integer for each node.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool DistanceMatrix::readFromStream(istream &in, const string &filename) {
+
+    string line;
+
+    while (getline(in, line)) {
+        stringstream ss(line);
+        string key, value;
+
+        getline(ss, key, ':');
+        getline(ss, value);
+
+        while (!value.empty() && value.front() == ' ') {
+            value.erase(0, 1);
+        }
+
+        if (key == "Mode" && (value == "driving" || value == "walking")) mode = value;
+
+        else if (key == "Sources") {
+            if (!parseIds(value, sources)) return false;
+        }
+
+        else if (key == "Targets") {
+            if (!parseIds(value, targets)) return false;
+        }
+
+        else if (key == "Paths") {
+            if (value == "yes") withPaths = true;
+            else if (value == "no" || value.empty()) withPaths = false;
+            else {
+                cout << "Invalid value for 'Paths'! Please enter 'yes' or 'no'.\n";
+                return false;
+            }
+        }
+
+        else {
+            cout << "Invalid input format in " << filename << "\n\n";
+            return false;
+        }
+    }
+
+    if (mode.empty() || sources.empty() || targets.empty()) {
+        cout << "Mode, Sources and Targets are mandatory!\n";
+        return false;
+    }
+
+    return true;
+}
+
+
+void DistanceMatrix::writeToFile(ostream &outFile) {
+    TRACE_SCOPE("DistanceMatrix::writeToFile", "write");
+
+    outFile << "Mode:" << mode << "\n";
+
+    outFile << "Sources:";
+    writeIds(outFile, sources);
+    outFile << "\n";
+
+    outFile << "Targets:";
+    writeIds(outFile, targets);
+    outFile << "\n";
+
+    // one row per source
+    outFile << "DistanceMatrix:\n";
+    string line;
+    for (size_t i = 0; i < times.size(); i++) {
+        line.clear();
+        appendInt(line, sources[i]);
+        line += ':';
+        for (size_t j = 0; j < times[i].size(); j++) {
+            if (j > 0) line += ',';
+            if (times[i][j] == INF) line += "none";
+            else appendInt(line, (int) times[i][j]);
+        }
+        line += '\n';
+        outFile.write(line.data(), line.size());
+    }
+
+    if (!withPaths) return;
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        for (size_t j = 0; j < paths[i].size(); j++) {
+            const vector<int> &path = paths[i][j];
+
+            outFile << "Path(" << sources[i] << "," << targets[j] << "):";
+            if (path.empty()) {
+                outFile << "none\n";
+                continue;
+            }
+            writeIds(outFile, path);
+            outFile << "(" << (int) times[i][j] << ")\n";
+        }
+    }
+}
+
+
+void DistanceMatrix::writeRecord(RecordWriter &out) {
+    TRACE_SCOPE("DistanceMatrix::writeRecord", "write");
+
+    out.beginRecord("matrix");
+    out.text("mode", mode);
+    out.path("sources", sources);
+    out.path("targets", targets);
+
+    // one item per source, with its time to each target
+    out.beginList("rows");
+    for (size_t i = 0; i < times.size(); i++) {
+        out.beginItem();
+        out.number("source", sources[i]);
+        out.beginList("times");
+        for (double t : times[i]) out.time(nullptr, t);
+        out.endList();
+        out.endItem();
+    }
+    out.endList();
+
+    if (withPaths) {
+        out.beginList("paths");
+        for (size_t i = 0; i < paths.size(); i++) {
+            for (size_t j = 0; j < paths[i].size(); j++) {
+                out.beginItem();
+                out.number("source", sources[i]);
+                out.number("target", targets[j]);
+                out.path("path", paths[i][j]);
+                out.time("time", paths[i][j].empty() ? INF : times[i][j]);
+                out.endItem();
+            }
+        }
+        out.endList();
+    }
+    out.endRecord();
+}
+
+
+void DistanceMatrix::calculateMatrix(unsigned threads) {
+
+    if (!cityMap) {
+        cout << "Error: cityMap is not initialized.\n";
+        return;
+    }
+
+    auto snapshot = liveMap(cityMap).getSnapshot();
+    const CompactGraph<Location> &compact = *snapshot;
+    bool driving = (mode == "driving");
+
+    vector<int> targetIdx;
+    for (int t : targets) targetIdx.push_back(compact.findIndex(t));
+
+    SweepOptions options;
+    options.targets = targetIdx;
+
+    times.assign(sources.size(), vector<double>(targets.size(), INF));
+    paths.assign(withPaths ? sources.size() : 0, vector<vector<int>>(targets.size()));
+
+    // each worker takes the next batch of sources that hasn't been searched yet
+    size_t batches = (sources.size() + RELAX_LANES - 1) / RELAX_LANES;
+    atomic<size_t> next{0};
+    SearchStats *stats = activeStats();
+    auto worker = [&]() {
+        StatsScope scope(stats);    // the workers count for this query too
+        MultiSearchLabels labels;
+        vector<int> batch;
+        for (size_t b = next++; b < batches; b = next++) {
+            batch.clear();
+            for (size_t i = b * RELAX_LANES; i < sources.size() && batch.size() < (size_t) RELAX_LANES; i++) {
+                batch.push_back(compact.findIndex(sources[i]));
+            }
+            multiSweep(compact, batch, driving, labels, options);
+
+            for (size_t k = 0; k < batch.size(); k++) {
+                size_t i = b * RELAX_LANES + k;
+                for (size_t j = 0; j < targetIdx.size(); j++) {
+                    times[i][j] = labels.getDist(k, targetIdx[j]);
+                    if (withPaths) paths[i][j] = getMultiSweepPath(compact, labels, k, targetIdx[j], driving);
+                }
+            }
+        }
+    };
+
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = min<size_t>(threads, batches);
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++) workers.emplace_back(worker);
+    worker();
+    for (auto &t : workers) t.join();
+}
+
+
+void DistanceMatrix::processRoute(ostream &outFile) {
+    {
+        PhaseTimer phase("matrix");
+        calculateMatrix();
+    }
+    PhaseTimer phase("write");
+    writeResult(outFile);
+}
+
+
+string DistanceMatrix::queryKey() const {
+    ostringstream key;
+    key << "matrix|" << mode << "|";
+    for (int s : sources) key << s << ",";
+    key << "|";
+    for (int t : targets) key << t << ",";
+    key << "|" << withPaths;
+    return key.str();
+}
+
+
+string DistanceMatrix::outcome() const {
+    for (auto &row : times) {
+        for (double t : row) {
+            if (t != INF) return "found";
+        }
+    }
+    return "none";
+}
+
+
+string DistanceMatrix::reuseKey() const {
+    return queryKey();
+}
+
+
+double DistanceMatrix::estimateCost() const {
+    return sources.size();
+}
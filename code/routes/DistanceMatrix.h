@@ -0,0 +1,134 @@
+/** @file DistanceMatrix.h
+ *  @brief Contains the definition of the DistanceMatrix class.
+ *
+ *  This file defines the DistanceMatrix class, which computes the driving or walking times between 
+ *  every pair of a list of sources and a list of targets, with their paths if requested.
+ */
+
+#ifndef DISTANCEMATRIX_H
+#define DISTANCEMATRIX_H
+
+#include <thread>
+#include <atomic>
+
+#include "Route.h"
+#include "sweep.h"
+#include "multisweep.h"
+#include "LiveMap.h"
+#include "../data_structures/CompactGraph.h"
+
+using namespace std;
+
+/**
+ * @class DistanceMatrix
+ * @brief Class for many-to-many route calculation, extending the Route class.
+ *
+ * The map has no precomputed index, so the matrix is filled by one-to-all searches over a compact 
+ * snapshot of the map, one per batch of RELAX_LANES sources (see multisweep.h), run in parallel. 
+ * Each search stops as soon as every target is settled for every source of its batch. The result 
+ * is a dense matrix with one row per source and one column per target.
+ */
+class DistanceMatrix : public Route {
+
+    public:
+
+        /**
+         * @brief Default constructor for DistanceMatrix.
+         * @param map A pointer to the Graph representing the map with locations.
+         */
+        DistanceMatrix(Graph<Location>* map) : Route(map,"",-1,-1), withPaths(false) {}
+
+        /**
+         * @brief Constructor for DistanceMatrix with specific mode, sources and targets.
+         * 
+         * @param map A pointer to the Graph representing the map with locations.
+         * @param m A string representing the mode of transportation ("driving", "walking").
+         * @param srcs The IDs of the source locations.
+         * @param tgts The IDs of the target locations.
+         * @param paths True if the paths should be retrieved along with the times.
+         */
+        DistanceMatrix(Graph<Location>* map, string m, const vector<int> &srcs, const vector<int> &tgts, bool paths)
+            : Route(map, m, -1, -1), sources(srcs), targets(tgts), withPaths(paths) {}
+
+        /**
+         * @brief Reads the matrix query from a stream of 'Key:value' lines.
+         * @param in The stream to read from.
+         * @param filename Name of the input, used in error messages.
+         * @return True if reading was successful, false otherwise.
+         */
+        bool readFromStream(istream &in, const string &filename) override;
+
+        /**
+         * @brief Writes the matrix to an output stream.
+         * @param outFile Output stream to write the matrix.
+         */
+        void writeToFile(ostream &outFile) override;
+
+        /**
+         * @brief Writes the route data as a record, for the JSON Lines and binary formats.
+         * @param out The writer of the record.
+         */
+        void writeRecord(RecordWriter &out) override;
+
+        /**
+         * @brief Calculates the times (and paths) between every source and target.
+         * @param threads Number of batches to search in parallel (0 uses the hardware concurrency).
+         */
+        void calculateMatrix(unsigned threads = 0);
+
+        /**
+         * @brief Processes the matrix, calling `calculateMatrix` and `writeToFile`.
+         * @param outFile The output stream where the matrix will be written.
+         */
+        void processRoute(ostream &outFile) override;
+
+        /**
+         * @brief Builds the canonical key of this query, used by the route cache.
+         * @return The canonical query key.
+         */
+        string queryKey() const override;
+
+        /**
+         * @brief Classifies the result of the last processing, for the query metrics.
+         * @return "found" or "none".
+         */
+        string outcome() const override;
+
+        /**
+         * @brief Builds the key of the searches that this query may share with other queries.
+         * @return The query key: matrices share no trees with other queries.
+         */
+        string reuseKey() const override;
+
+        /**
+         * @brief Estimates the work of processing this route, to schedule the longest queries first.
+         * @return One search per source.
+         */
+        double estimateCost() const override;
+
+        /**
+         * @brief Gets the computed times.
+         * @return One row per source, one column per target (INF if unreachable).
+         */
+        const vector<vector<double>> &getTimes() const { return times; }
+
+
+    private:
+        vector<int> sources;                ///< IDs of the source locations (rows).
+        vector<int> targets;                ///< IDs of the target locations (columns).
+        bool withPaths;                     ///< True if the paths should be retrieved.
+        vector<vector<double>> times;       ///< Time from each source to each target.
+        vector<vector<vector<int>>> paths;  ///< Path from each source to each target, if requested.
+
+        /**
+         * @brief Parses a comma separated list of location IDs present in the map.
+         * @param value The list to parse.
+         * @param ids Vector where the IDs are appended.
+         * @return True if every ID is valid, false otherwise.
+         */
+        bool parseIds(const string &value, vector<int> &ids);
+};
+
+
+
+#endif
@@ -7,9 +7,9 @@ using namespace std;
 vector<int> EcoRoute::findParking(int source, int dest) {
     vector<int> parkingNodes;
     for (auto vertex : cityMap->getVertexSet()) {
-        Location loc = vertex->getInfo();
+        const Location &loc = vertex->getInfo();
         if (loc.hasParking() && loc.getId() != source && loc.getId() != dest) {
-            parkingNodes.push_back(vertex->getInfo().getId());
+            parkingNodes.push_back(loc.getId());
         }
     }
     return parkingNodes;
@@ -17,18 +17,11 @@ vector<int> EcoRoute::findParking(int source, int dest) {
 
 
 
-bool EcoRoute::readFromFile(const string &filename) {
-    
-    ifstream inFile(filename);
-
-    if (!inFile ) {
-        cout << "\nError opening files.\n";
-        return false;
-    }
+bool EcoRoute::readFromStream(istream &in, const string &filename) {
 
     string line;
 
-    while (getline(inFile, line)) {
+    while (getline(in, line)) {
         stringstream ss(line);
         string key, value, value2;
 
@@ -49,7 +42,7 @@ bool EcoRoute::readFromFile(const string &filename) {
                     cout << "Invalid source ID! Must be a positive integer.\n";
                     return false;
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid source ID! Please enter a valid integer.\n";
                 return false;
             } 
@@ -64,7 +57,7 @@ bool EcoRoute::readFromFile(const string &filename) {
                     cout << "Invalid destination ID! Must be a positive integer.\n";
                     return false;
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid destination ID! Please enter a valid integer.\n";
                 return false;
             } 
@@ -78,68 +71,18 @@ bool EcoRoute::readFromFile(const string &filename) {
                     cout << "MaxWalkTime must be a positive integer!\n";
                     return false;
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid time! Please enter a valid integer.\n";
                 return false;
             } 
         } 
 
         else if (key == "AvoidNodes") {
-            if (!value.empty()) {
-                stringstream nodes(value);
-                string node;
-                while (getline(nodes, node, ',')) {
-                    if (!node.empty()) {
-                        try {
-                            int id = stoi(node);  
-                            if (id == source || id == dest) {
-                                cout << "Can't avoid source/dest nodes! Node " << id << " is either the source or destination.\n";
-                            } else {
-                                if (cityMap->findLocationId(id) == nullptr) return false;
-                                else avoidNodes.push_back(id);
-                            }
-                        } catch (const invalid_argument& e) {
-                            cout << "Invalid node ID in 'AvoidNodes' field! Please enter a valid integer for each node.\n";
-                            return false;
-                        }
-                    }
-                }
-            }
+            if (!readAvoidNodes(value, avoidNodes)) return false;
         }
 
         else if (key == "AvoidSegments") {
-            if (!value.empty()) {
-                stringstream segs(value);
-                string seg;
-
-                while (getline(segs, seg, ')')) { 
-
-                    // The segment itself
-                    if (!seg.empty()) {
-        
-                        // "(src,dest" -> "src,dest"
-                        seg.erase(remove(seg.begin(), seg.end(), '('), seg.end());
-        
-                        stringstream pairNodes(seg);
-                        int src, dst;
-                        char comma;
-                
-                        // We extract src and dest
-                        if (pairNodes >> src >> comma >> dst && comma == ',') {
-                            if (cityMap->findLocationId(src) == nullptr || cityMap->findLocationId(dst) == nullptr) return false;
-                            else avoidSegs.push_back(make_pair(src, dst));
-                        } else {
-                            cout << "Invalid segment format.\n";
-                            return false; 
-                        }
-                    }
-        
-                    // The comma separating segments
-                    char separator;
-                    segs >> separator; 
-                }
-            }    
-
+            if (!readAvoidSegments(value, avoidSegs)) return false;
         }
         
         else {
@@ -148,12 +91,12 @@ bool EcoRoute::readFromFile(const string &filename) {
         }
     }
 
-    inFile.close();
     return true;
 }
 
 
 void EcoRoute::writeToFile(ostream &outFile) {
+    TRACE_SCOPE("EcoRoute::writeToFile", "write");
 
     if (cityMap->findLocationId(source) == nullptr) outFile << "Invalid source id! Please enter a node id present in the graph.\n";
     else outFile << "Source:" << source << '\n';
@@ -166,10 +109,7 @@ void EcoRoute::writeToFile(ostream &outFile) {
         outFile << "none\n";
     } else {
         
-        for (size_t i = 0; i < drivingRoute.size(); i++) {
-            outFile << drivingRoute[i];
-            if (i < drivingRoute.size() - 1) outFile << ",";
-        }
+        writeIds(outFile, drivingRoute);
         outFile << "(" << drivingTime << ")\n";
     }
 
@@ -182,10 +122,7 @@ void EcoRoute::writeToFile(ostream &outFile) {
     if (walkingRoute.empty()) {
         outFile << "none\n";
     } else {
-        for (size_t i = 0; i < walkingRoute.size(); i++) {
-            outFile << walkingRoute[i];
-            if (i < walkingRoute.size() - 1) outFile << ",";
-        }
+        writeIds(outFile, walkingRoute);
         outFile << "(" << walkingTime << ")\n";
     }
 
@@ -202,12 +139,55 @@ void EcoRoute::writeToFile(ostream &outFile) {
 
 
 
+void EcoRoute::writeRecord(RecordWriter &out) {
+    TRACE_SCOPE("EcoRoute::writeRecord", "write");
+
+    auto writeLegs = [&](const vector<int> &driving, int dt, int parking, const vector<int> &walking, int wt, int total) {
+        out.path("drivingRoute", driving);
+        if (driving.empty()) out.none("drivingTime");
+        else out.number("drivingTime", dt);
+
+        if (parking == -1) out.none("parkingNode");
+        else out.number("parkingNode", parking);
+
+        out.path("walkingRoute", walking);
+        if (walking.empty()) out.none("walkingTime");
+        else out.number("walkingTime", wt);
+
+        if (total == 0) out.none("totalTime");
+        else out.number("totalTime", total);
+    };
+
+    out.beginRecord("eco");
+    if (cityMap->findLocationId(source) == nullptr) out.none("source");
+    else out.number("source", source);
+    if (cityMap->findLocationId(dest) == nullptr) out.none("destination");
+    else out.number("destination", dest);
+
+    writeLegs(drivingRoute, drivingTime, parkingNode, walkingRoute, walkingTime, time);
+    if (message.empty()) out.none("message");
+    else out.text("message", message);
+
+    // the same approximate solutions as `calculateAproxSolution`, only when there is no route
+    out.beginList("approximations");
+    size_t best = drivingRoute.empty() ? sortAproxSolutions() : 0;
+    for (size_t i = 0; i < best; i++) {
+        const AproxSolution &cur = aproxSolutions[i];
+        out.beginItem();
+        writeLegs(cur.drivingRoute, cur.drivingTime, cur.parkingNode, cur.walkingRoute, cur.walkingTime, cur.time);
+        out.endItem();
+    }
+    out.endList();
+    out.endRecord();
+}
+
+
 bool EcoRoute::calculateRoute() {
     
-    Graph<Location>* copy = copyGraph(cityMap);
-
-    copy->avoidVertices(avoidNodes);
-    copy->avoidEdges(avoidSegs);
+    // the map without the nodes and segments to avoid, shared with other queries with the same restrictions
+    shared_ptr<RestrictionSet> restrictions = liveMap(cityMap).getRestrictions(avoidNodes, avoidSegs);
+    RestrictionSet::Lease lease = restrictions->lease();
+    Graph<Location>* copy = lease.get();
 
     int minTotalTime = numeric_limits<int>::max();
     bool validRoute = false;
@@ -219,13 +199,34 @@ bool EcoRoute::calculateRoute() {
     if (parkingNodes.empty()) failureReason = "No available parking nodes.\n";
 
 
+    // the driving tree of the source is shared with other queries from it with the same restrictions
+    vector<pair<vector<int>, int>> drivingLegs;
+    shared_ptr<SourceTree> drivingTree = liveMap(cityMap).getSourceTree(source, true, restrictions);
     for (int parking : parkingNodes) {
+        double dist;
+        vector<int> drivingPath = drivingTree->getPath(parking, dist);
+        drivingLegs.push_back({drivingPath, drivingPath.empty() ? 0 : (int) dist});
+    }
+
+    shared_ptr<const ParkingCatchment> catchment = liveMap(cityMap).getCatchment();
 
-        if (initDijkstra(copy)) dijkstra(copy, source, parking, 1);
-        vector<int> drivingPath = getPath(copy, source, parking);
+    for (size_t i = 0; i < parkingNodes.size(); i++) {
+        int parking = parkingNodes[i];
+        const vector<int> &drivingPath = drivingLegs[i].first;
         if (drivingPath.empty()) continue; 
 
-        int dt = copy->findLocationId(parking)->getDist();
+        int dt = drivingLegs[i].second;
+
+        // the walk can't be shorter than on the whole map, so this parking node can't beat the route found
+        if (validRoute) {
+            double walk = catchment->walkingLowerBound(parking, dest);
+            if (walk > maxWalk || dt + walk > minTotalTime) continue;
+        }
+
+        // once a route is found, a walk longer than it or than the limit can't improve it
+        SearchLimits limits;
+        limits.targets = {dest};
+        if (validRoute) limits.maxDist = min(maxWalk, minTotalTime - dt);
 
         if (initDijkstra(copy)) {
             for (int i = 0; i < drivingPath.size()-1; i++) {
@@ -233,13 +234,14 @@ bool EcoRoute::calculateRoute() {
                 p->setVisited(true);
             }
             
-            dijkstra(copy, parking, dest, 0);
+            dijkstra<WalkingMetric>(copy, parking, limits);
         }
 
         vector<int> walkingPath = getPath(copy, parking, dest);
         if (walkingPath.empty()) continue; 
 
         int wt = copy->findLocationId(dest)->getDist();
+        if (wt > limits.maxDist) continue;      // not settled within the limit
 
         int totalTime = dt + wt;
 
@@ -264,8 +266,6 @@ bool EcoRoute::calculateRoute() {
         }
     }
 
-    delete copy; //we free mem
-
     if (!validRoute) {
         message = failureReason;
         return false;
@@ -274,6 +274,17 @@ bool EcoRoute::calculateRoute() {
 }
 
 
+size_t EcoRoute::sortAproxSolutions() {
+    //we sort the solutions by best total time
+    sort(aproxSolutions.begin(), aproxSolutions.end(), 
+              [](const AproxSolution& a, const AproxSolution& b) {
+                  return a.time < b.time;
+              }
+        );
+    return min(aproxSolutions.size(), size_t(2));
+}
+
+
 void EcoRoute::calculateAproxSolution(ostream &outFile) {
 
     if (aproxSolutions.empty()) {
@@ -286,15 +297,9 @@ void EcoRoute::calculateAproxSolution(ostream &outFile) {
     outFile << "Source:" << source << "\n";
     outFile << "Destination:" << dest << "\n";
 
-    //we sort the solutions by best total time
-    sort(aproxSolutions.begin(), aproxSolutions.end(), 
-              [](const AproxSolution& a, const AproxSolution& b) {
-                  return a.time < b.time;
-              }
-        );
-
     //we only process the first 2 solutions w/ best time
-    for (size_t i = 0; i < min(aproxSolutions.size(), size_t(2)); i++) {
+    size_t best = sortAproxSolutions();
+    for (size_t i = 0; i < best; i++) {
 
         AproxSolution cur = aproxSolutions[i];
 
@@ -304,10 +309,7 @@ void EcoRoute::calculateAproxSolution(ostream &outFile) {
             outFile << "none\n";
         } else {
             
-            for (size_t i = 0; i < cur.drivingRoute.size(); i++) {
-                outFile << cur.drivingRoute[i];
-                if (i < cur.drivingRoute.size() - 1) outFile << ",";
-            }
+            writeIds(outFile, cur.drivingRoute);
             outFile << "(" << cur.drivingTime << ")\n";
         }
     
@@ -322,10 +324,7 @@ void EcoRoute::calculateAproxSolution(ostream &outFile) {
             outFile << "none\n";
         } else {
             
-            for (size_t i = 0; i < cur.walkingRoute.size(); i++) {
-                outFile << cur.walkingRoute[i];
-                if (i < cur.walkingRoute.size() - 1) outFile << ",";
-            }
+            writeIds(outFile, cur.walkingRoute);
             outFile << "(" << cur.walkingTime << ")\n";
         }
     
@@ -339,7 +338,35 @@ void EcoRoute::calculateAproxSolution(ostream &outFile) {
 
 
 void EcoRoute::processRoute(ostream &outFile) {
-    bool success = calculateRoute();
-    writeToFile(outFile);
-    if (!success) calculateAproxSolution(outFile);    
-}
\ No newline at end of file
+    bool success;
+    {
+        PhaseTimer phase("route");
+        success = calculateRoute();
+    }
+    PhaseTimer phase("write");
+    writeResult(outFile);
+    if (!success && getOutputFormat() == OutputFormat::Text) calculateAproxSolution(outFile);    
+}
+
+
+string EcoRoute::queryKey() const {
+    ostringstream key;
+    key << "eco|" << mode << "|" << source << "|" << dest << "|" << canonicalRestrictions(avoidNodes, avoidSegs) << "|" << maxWalk;
+    return key.str();
+}
+
+
+string EcoRoute::outcome() const {
+    if (!drivingRoute.empty()) return "found";
+    return aproxSolutions.empty() ? "none" : "approximate";
+}
+
+
+string EcoRoute::reuseKey() const {
+    return to_string(source) + "|driving|" + canonicalRestrictions(avoidNodes, avoidSegs);
+}
+
+
+double EcoRoute::estimateCost() const {
+    return 1 + liveMap(cityMap).getParkingCount();
+}
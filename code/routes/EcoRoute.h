@@ -12,6 +12,7 @@
 #define ECOROUTE_H
 
 #include "Route.h"
+#include "LiveMap.h"
 using namespace std;
 
 /**
@@ -61,11 +62,12 @@ class EcoRoute : public Route {
             :  Route(map,m,src,dt), maxWalk(mw), avoidNodes(avoidN), avoidSegs(avoidS), parkingNode(-1), time(0), drivingTime(0), walkingTime(0) {}
 
         /**
-         * @brief Reads route data from a file.
-         * @param filename Name of the file to read from.
+         * @brief Reads route data from a stream of 'Key:value' lines.
+         * @param in The stream to read from.
+         * @param filename Name of the input, used in error messages.
          * @return True if reading was successful, false otherwise.
          */
-        bool readFromFile(const string &filename) override;
+        bool readFromStream(istream &in, const string &filename) override;
 
         /**
          * @brief Writes route data to an output stream.
@@ -73,6 +75,12 @@ class EcoRoute : public Route {
          */
         void writeToFile(ostream &outFile) override;
 
+        /**
+         * @brief Writes the route data as a record, for the JSON Lines and binary formats.
+         * @param out The writer of the record.
+         */
+        void writeRecord(RecordWriter &out) override;
+
         /**
          * @brief Calculates the eco-friendly route with a combination of driving and walking.
          * @return True if a valid route is found, false otherwise.
@@ -91,6 +99,30 @@ class EcoRoute : public Route {
          */
         void processRoute(ostream &outFile) override;
 
+        /**
+         * @brief Builds the canonical key of this query, used by the route cache.
+         * @return The canonical query key.
+         */
+        string queryKey() const override;
+
+        /**
+         * @brief Classifies the result of the last processing, for the query metrics.
+         * @return "found", "none" or "approximate".
+         */
+        string outcome() const override;
+
+        /**
+         * @brief Builds the key of the searches that this query may share with other queries.
+         * @return The source, the driving mode and the restrictions, shared with the driving legs of restricted routes.
+         */
+        string reuseKey() const override;
+
+        /**
+         * @brief Estimates the work of processing this route, to schedule the longest queries first.
+         * @return One driving search and a walking search per parking node.
+         */
+        double estimateCost() const override;
+
 
     private:
         vector<int> avoidNodes; ///< List of nodes to avoid in the route.
@@ -107,6 +139,12 @@ class EcoRoute : public Route {
 
         vector<AproxSolution> aproxSolutions; ///< Stores alternative route solutions when the main route isn't possible.
 
+        /**
+         * @brief Sorts the approximate solutions by total time.
+         * @return The number of them that are written (the best 2 at most).
+         */
+        size_t sortAproxSolutions();
+
         /**
          * @brief Finds available parking locations.
          * @param source The starting node ID.
@@ -2,18 +2,11 @@
 using namespace std;
 
 
-bool IndependentRoute::readFromFile(const string &filename) {
-    
-    ifstream inFile(filename);
-
-    if (!inFile ) {
-        cout << "\nError opening files.\n";
-        return false;
-    }
+bool IndependentRoute::readFromStream(istream &in, const string &filename) {
 
     string line;
 
-    while (getline(inFile, line)) {
+    while (getline(in, line)) {
         stringstream ss(line);
         string key, value;
 
@@ -35,7 +28,7 @@ bool IndependentRoute::readFromFile(const string &filename) {
                     cout << "Invalid source ID! Must be a positive integer.\n";
                     return false;
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid source ID! Please enter a valid integer.\n";
                 return false;
             } 
@@ -50,7 +43,7 @@ bool IndependentRoute::readFromFile(const string &filename) {
                     cout << "Invalid destination ID! Must be a positive integer.\n";
                     return false;
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid destination ID! Please enter a valid integer.\n";
                 return false;
             } 
@@ -63,12 +56,12 @@ bool IndependentRoute::readFromFile(const string &filename) {
     }
 
 
-    inFile.close();
     return true;
 }
 
 
 void IndependentRoute::writeToFile(ostream &outFile) {
+    TRACE_SCOPE("IndependentRoute::writeToFile", "write");
 
     if (cityMap->findLocationId(source) == nullptr) outFile << "Invalid source id! Please enter a node id present in the graph.\n";
     else outFile << "Source:" << source << "\n";
@@ -81,10 +74,7 @@ void IndependentRoute::writeToFile(ostream &outFile) {
     if (bestRoute.empty()) {
         outFile << "none\n";
     } else {
-        for (size_t i = 0; i < bestRoute.size(); i++) {
-            outFile << bestRoute[i];
-            if (i < bestRoute.size() - 1) outFile << ",";
-        }
+        writeIds(outFile, bestRoute);
         outFile << "(" << bestTime << ")\n";
     }
 
@@ -94,16 +84,33 @@ void IndependentRoute::writeToFile(ostream &outFile) {
     if (altRoute.empty()) {
         outFile << "none\n";
     } else {
-        for (size_t i = 0; i < altRoute.size(); i++) {
-            outFile << altRoute[i];
-            if (i < altRoute.size() - 1) outFile << ",";
-        }
+        writeIds(outFile, altRoute);
         outFile << "(" << altTime << ")\n";
     }
 
 }
 
 
+void IndependentRoute::writeRecord(RecordWriter &out) {
+    TRACE_SCOPE("IndependentRoute::writeRecord", "write");
+
+    out.beginRecord("independent");
+    if (cityMap->findLocationId(source) == nullptr) out.none("source");
+    else out.number("source", source);
+    if (cityMap->findLocationId(dest) == nullptr) out.none("destination");
+    else out.number("destination", dest);
+
+    out.path("bestRoute", bestRoute);
+    if (bestRoute.empty()) out.none("bestTime");
+    else out.number("bestTime", bestTime);
+
+    out.path("alternativeRoute", altRoute);
+    if (altRoute.empty()) out.none("alternativeTime");
+    else out.number("alternativeTime", altTime);
+    out.endRecord();
+}
+
+
 void IndependentRoute::calculateBestRoute() {
 
     if (!cityMap) {
@@ -111,12 +118,10 @@ void IndependentRoute::calculateBestRoute() {
         return;
     }
     
-    if (initDijkstra(cityMap)) dijkstra(cityMap, source, dest, 1);
-    
-    bestRoute = getPath(cityMap, source, dest);
-
-    Vertex<Location> *destVertex = cityMap->findLocationId(dest);
-    bestTime = destVertex->getDist();
+    // queries from the same source share its tree, grown only as far as their destinations
+    double dist;
+    bestRoute = liveMap(cityMap).getSourceTree(source, true)->getPath(dest, dist);
+    bestTime = dist;
 }
 
 
@@ -128,7 +133,7 @@ void IndependentRoute::calculateAltRoute() {
         return;
     }
 
-    Graph<Location>* copy = copyGraph(cityMap);
+    Graph<Location>* copy = timedCopyGraph(cityMap);
 
     for (int i = 1; i < bestRoute.size()-1; i++) {
         int id = bestRoute[i];
@@ -142,7 +147,7 @@ void IndependentRoute::calculateAltRoute() {
 
 
     //from here is the same logic as best route
-    if (initDijkstra(copy)) dijkstra(copy, source, dest, 1);
+    if (initDijkstra(copy)) dijkstra<DrivingMetric>(copy, source, dest);
 
     altRoute = getPath(copy, source, dest);
 
@@ -156,7 +161,36 @@ void IndependentRoute::calculateAltRoute() {
 
 
 void IndependentRoute::processRoute(ostream &outFile) {
-    calculateBestRoute();
-    calculateAltRoute();
-    writeToFile(outFile);    
-}
\ No newline at end of file
+    {
+        PhaseTimer phase("best");
+        calculateBestRoute();
+    }
+    {
+        PhaseTimer phase("alternative");
+        calculateAltRoute();
+    }
+    PhaseTimer phase("write");
+    writeResult(outFile);    
+}
+
+
+string IndependentRoute::queryKey() const {
+    ostringstream key;
+    key << "independent|" << mode << "|" << source << "|" << dest;
+    return key.str();
+}
+
+
+string IndependentRoute::outcome() const {
+    return bestRoute.empty() ? "none" : "found";
+}
+
+
+string IndependentRoute::reuseKey() const {
+    return to_string(source) + "|driving";
+}
+
+
+double IndependentRoute::estimateCost() const {
+    return 2;
+}
@@ -10,6 +10,7 @@
 #define INDEPENDENTROUTE_H
 
 #include "Route.h"
+#include "LiveMap.h"
 
 using namespace std;
 
@@ -52,11 +53,12 @@ class IndependentRoute : public Route {
             :  Route(map, m, src, dt), bestTime(0), altTime(0) {}
         
         /**
-         * @brief Reads route data from a file.
-         * @param filename Name of the file to read from.
+         * @brief Reads route data from a stream of 'Key:value' lines.
+         * @param in The stream to read from.
+         * @param filename Name of the input, used in error messages.
          * @return True if reading was successful, false otherwise.
          */
-        bool readFromFile(const string &filename) override;
+        bool readFromStream(istream &in, const string &filename) override;
 
         /**
          * @brief Writes route data to an output stream.
@@ -64,6 +66,12 @@ class IndependentRoute : public Route {
          */
         void writeToFile(ostream &outFile) override;
 
+        /**
+         * @brief Writes the route data as a record, for the JSON Lines and binary formats.
+         * @param out The writer of the record.
+         */
+        void writeRecord(RecordWriter &out) override;
+
         /**
          * @brief Calculates the best route between the source and destination.
 
@@ -85,6 +93,30 @@ class IndependentRoute : public Route {
          */
         void processRoute(ostream &outFile) override;
 
+        /**
+         * @brief Builds the canonical key of this query, used by the route cache.
+         * @return The canonical query key.
+         */
+        string queryKey() const override;
+
+        /**
+         * @brief Classifies the result of the last processing, for the query metrics.
+         * @return "found" or "none".
+         */
+        string outcome() const override;
+
+        /**
+         * @brief Builds the key of the searches that this query may share with other queries.
+         * @return The source and the driving mode.
+         */
+        string reuseKey() const override;
+
+        /**
+         * @brief Estimates the work of processing this route, to schedule the longest queries first.
+         * @return Two searches: the best route and the alternative one, on a copy of the map.
+         */
+        double estimateCost() const override;
+
     private:
         vector<int> bestRoute;  ///< Vector holding the best route's vertex IDs.
         vector<int> altRoute;   ///< Vector holding the alternative route's vertex IDs.
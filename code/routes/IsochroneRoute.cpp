@@ -0,0 +1,201 @@
+#include "IsochroneRoute.h"
+
+using namespace std;
+
+
+bool IsochroneRoute::readFromStream(istream &in, const string &filename) {
+
+    string line;
+
+    while (getline(in, line)) {
+        stringstream ss(line);
+        string key, value;
+
+        getline(ss, key, ':');
+        getline(ss, value);
+
+        while (!value.empty() && value.front() == ' ') {
+            value.erase(0, 1);
+        }
+
+        if (key == "Mode" && (value == "driving" || value == "walking" || value == "driving-walking")) mode = value;
+
+        else if (key == "Source") {
+            try {
+                int tempSource = stoi(value);
+                if (tempSource > 0) {
+                    source = tempSource;
+                } else {
+                    cout << "Invalid source ID! Must be a positive integer.\n";
+                    return false;
+                }
+            } catch (const logic_error& e) {
+                cout << "Invalid source ID! Please enter a valid integer.\n";
+                return false;
+            } 
+        }
+
+        else if (key == "MaxTime") {
+            try {
+                int mt = stoi(value);
+                if (mt >= 0) maxTime = mt;
+                else {
+                    cout << "MaxTime must be a positive integer!\n";
+                    return false;
+                }
+            } catch (const logic_error& e) {
+                cout << "Invalid time! Please enter a valid integer.\n";
+                return false;
+            } 
+        }
+
+        else if (key == "AvoidNodes") {
+            if (!readAvoidNodes(value, avoidNodes)) return false;
+        }
+
+        else if (key == "AvoidSegments") {
+            if (!readAvoidSegments(value, avoidSegs)) return false;
+        }
+
+        else {
+            cout << "Invalid input format in " << filename << "\n\n";
+            return false;
+        }
+    }
+
+    if (mode.empty() || maxTime < 0) {
+        cout << "Mode and MaxTime are mandatory!\n";
+        return false;
+    }
+
+    return true;
+}
+
+
+void IsochroneRoute::writeToFile(ostream &outFile) {
+    TRACE_SCOPE("IsochroneRoute::writeToFile", "write");
+
+    if (cityMap->findLocationId(source) == nullptr) outFile << "Invalid source id! Please enter a node id present in the graph.\n";
+    else outFile << "Source:" << source << "\n";
+
+    outFile << "Mode:" << mode << "\n";
+    outFile << "MaxTime:" << maxTime << "\n";
+
+    outFile << "ReachableLocations:";
+    if (reachable.empty()) {
+        outFile << "none\n";
+    } else {
+        string line;
+        for (size_t i = 0; i < reachable.size(); i++) {
+            if (i > 0) line += ',';
+            appendInt(line, reachable[i].first);
+            line += '(';
+            appendInt(line, reachable[i].second);
+            line += ')';
+        }
+        line += '\n';
+        outFile.write(line.data(), line.size());
+    }
+
+    outFile << "ReachableCount:" << reachable.size() << "\n";
+}
+
+
+void IsochroneRoute::writeRecord(RecordWriter &out) {
+    TRACE_SCOPE("IsochroneRoute::writeRecord", "write");
+
+    out.beginRecord("isochrone");
+    if (cityMap->findLocationId(source) == nullptr) out.none("source");
+    else out.number("source", source);
+    out.text("mode", mode);
+    out.number("maxTime", maxTime);
+
+    vector<int> locations, times;
+    for (const auto &[id, t] : reachable) {
+        locations.push_back(id);
+        times.push_back(t);
+    }
+    out.path("locations", locations);
+    out.beginList("times");
+    for (int t : times) out.number(nullptr, t);
+    out.endList();
+    out.number("count", reachable.size());
+    out.endRecord();
+}
+
+
+void IsochroneRoute::calculateIsochrone() {
+
+    reachable.clear();
+
+    LiveMap &live = liveMap(cityMap);
+    auto snapshot = live.getSnapshot();
+    const CompactGraph<Location> &compact = *snapshot;
+    int s = compact.findIndex(source);
+    if (s == -1) return;
+
+    shared_ptr<const SearchMask> mask = live.getRestrictions(avoidNodes, avoidSegs)->getMask(compact);
+    SweepOptions options;
+    options.mask = mask.get();
+    options.limit = maxTime;
+
+    SearchLabels labels;
+
+    if (mode == "driving-walking") {
+        SearchLabels driving;
+        searchFrom(compact, {{s, 0.0}}, true, driving, options);
+
+        // walk from every parking node reached by car, starting with the driving time
+        vector<pair<int, double>> seeds;
+        for (int v : driving.reached) {
+            if (v != s && compact.getInfo(v).hasParking()) seeds.push_back({v, driving.dist[v]});
+        }
+        searchFrom(compact, seeds, false, labels, options);
+    } 
+    
+    else {
+        searchFrom(compact, {{s, 0.0}}, mode == "driving", labels, options);
+    }
+
+    for (int v : labels.reached) {
+        reachable.push_back({compact.getId(v), (int) labels.dist[v]});
+    }
+
+    sort(reachable.begin(), reachable.end(), 
+        [](const pair<int, int> &a, const pair<int, int> &b) {
+            return a.second < b.second || (a.second == b.second && a.first < b.first);
+        }
+    );
+}
+
+
+void IsochroneRoute::processRoute(ostream &outFile) {
+    {
+        PhaseTimer phase("isochrone");
+        calculateIsochrone();
+    }
+    PhaseTimer phase("write");
+    writeResult(outFile);
+}
+
+
+string IsochroneRoute::queryKey() const {
+    ostringstream key;
+    key << "isochrone|" << mode << "|" << source << "|" << canonicalRestrictions(avoidNodes, avoidSegs) << "|" << maxTime;
+    return key.str();
+}
+
+
+string IsochroneRoute::outcome() const {
+    return reachable.empty() ? "none" : "found";
+}
+
+
+string IsochroneRoute::reuseKey() const {
+    return to_string(source) + "|" + mode + "|" + canonicalRestrictions(avoidNodes, avoidSegs);
+}
+
+
+double IsochroneRoute::estimateCost() const {
+    return mode == "driving-walking" ? 2 : 1;
+}
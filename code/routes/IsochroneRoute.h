@@ -0,0 +1,123 @@
+/** @file IsochroneRoute.h
+ *  @brief Contains the definition of the IsochroneRoute class.
+ *
+ *  This file defines the IsochroneRoute class, which finds every location that can be reached from 
+ *  a source within a time budget, by driving, by walking, or by driving to a parking node and walking 
+ *  from there (as in EcoRoute). Nodes and segments can be avoided as in RestrictedRoute.
+ */
+
+#ifndef ISOCHRONEROUTE_H
+#define ISOCHRONEROUTE_H
+
+#include "Route.h"
+#include "sweep.h"
+#include "deltastep.h"
+#include "LiveMap.h"
+#include "../data_structures/CompactGraph.h"
+
+using namespace std;
+
+/**
+ * @class IsochroneRoute
+ * @brief Class for handling isochrone queries, extending the Route class.
+ *
+ * The searches run over a compact snapshot of the map with the restrictions applied as a mask, 
+ * and stop at the time budget, so only the part of the map inside the isochrone is explored.
+ * In "driving-walking" mode, a single walking search is started from every parking node reached 
+ * by car within the budget, each one starting with the time needed to drive there.
+ */
+class IsochroneRoute : public Route {
+
+    public:
+
+        /**
+         * @brief Default constructor for IsochroneRoute.
+         * @param map A pointer to the Graph representing the map with locations.
+         */
+        IsochroneRoute(Graph<Location>* map) : Route(map,"",-1,-1), maxTime(-1) {}
+
+        /**
+         * @brief Constructor for IsochroneRoute with specific mode, source, budget and restrictions.
+         * 
+         * @param map A pointer to the Graph representing the map with locations.
+         * @param m A string representing the mode of transportation ("driving", "walking", "driving-walking").
+         * @param src The ID of the source location.
+         * @param mt The time budget.
+         * @param avoidN A vector of node IDs to avoid.
+         * @param avoidS A vector of pairs representing edge segments to avoid (start, end).
+         */
+        IsochroneRoute(Graph<Location>* map, string m, const int src, const int mt, const vector<int> &avoidN, const vector<pair<int, int>> &avoidS)
+            : Route(map, m, src, -1), avoidNodes(avoidN), avoidSegs(avoidS), maxTime(mt) {}
+
+        /**
+         * @brief Reads the isochrone query from a stream of 'Key:value' lines.
+         * @param in The stream to read from.
+         * @param filename Name of the input, used in error messages.
+         * @return True if reading was successful, false otherwise.
+         */
+        bool readFromStream(istream &in, const string &filename) override;
+
+        /**
+         * @brief Writes the reachable locations to an output stream.
+         * @param outFile Output stream to write the results.
+         */
+        void writeToFile(ostream &outFile) override;
+
+        /**
+         * @brief Writes the route data as a record, for the JSON Lines and binary formats.
+         * @param out The writer of the record.
+         */
+        void writeRecord(RecordWriter &out) override;
+
+        /**
+         * @brief Calculates every location reachable within the time budget.
+         */
+        void calculateIsochrone();
+
+        /**
+         * @brief Processes the query, calling `calculateIsochrone` and `writeToFile`.
+         * @param outFile The output stream where the results will be written.
+         */
+        void processRoute(ostream &outFile) override;
+
+        /**
+         * @brief Builds the canonical key of this query, used by the route cache.
+         * @return The canonical query key.
+         */
+        string queryKey() const override;
+
+        /**
+         * @brief Classifies the result of the last processing, for the query metrics.
+         * @return "found" or "none".
+         */
+        string outcome() const override;
+
+        /**
+         * @brief Builds the key of the searches that this query may share with other queries.
+         * @return The source, the mode and the restrictions.
+         */
+        string reuseKey() const override;
+
+        /**
+         * @brief Estimates the work of processing this route, to schedule the longest queries first.
+         * @return One search, or two for park-and-walk.
+         */
+        double estimateCost() const override;
+
+        /**
+         * @brief Gets the reachable locations.
+         * @return Pairs of (location ID, time), sorted by time.
+         */
+        const vector<pair<int, int>> &getReachable() const { return reachable; }
+
+
+    private:
+        vector<int> avoidNodes;             ///< Vector of node IDs to avoid.
+        vector<pair<int, int>> avoidSegs;   ///< Vector of edge segments to avoid (start, end).
+        int maxTime;                        ///< The time budget.
+        vector<pair<int, int>> reachable;   ///< Reachable locations and their times, sorted by time.
+};
+
+
+
+#endif
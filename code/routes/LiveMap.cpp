@@ -0,0 +1,258 @@
+#include "LiveMap.h"
+
+using namespace std;
+
+
+shared_mutex &LiveMap::getLock() {
+    return lock;
+}
+
+
+mutex &LiveMap::getLabelLock() {
+    return labelLock;
+}
+
+
+shared_ptr<CompactGraph<Location>> LiveMap::currentSnapshot() {
+    if (!snapshot || snapshot->getVersion() != cityMap->getVersion()) {
+        snapshot = make_shared<CompactGraph<Location>>(*cityMap);
+        sourceTrees.clear();    // computed on the old structure
+        copyOrder.reset();
+
+        parkingCount = 0;
+        for (int v = 0; v < snapshot->getNumVertex(); v++) {
+            if (snapshot->getInfo(v).hasParking()) parkingCount++;
+        }
+    }
+    return snapshot;
+}
+
+
+shared_ptr<const CompactGraph<Location>> LiveMap::getSnapshot() {
+    lock_guard<mutex> guard(cacheLock);
+    return currentSnapshot();
+}
+
+
+shared_ptr<SourceTree> LiveMap::getSourceTree(int sourceId, bool mode, shared_ptr<RestrictionSet> restrictions) {
+    lock_guard<mutex> guard(cacheLock);
+    auto graph = currentSnapshot();
+
+    // queries with restrictions search a pruned copy, whose edges are in another order than those of the map
+    auto &entry = sourceTrees[{sourceId, mode, restrictions ? "copy|" + restrictions->getKey() : "map"}];
+    entry.second = ++sourceTreeUses;
+    if (entry.first) return entry.first;
+
+    if (!restrictions) {
+        entry.first = make_shared<SourceTree>(graph, sourceId, mode);
+    } else {
+        if (!copyOrder) copyOrder = make_shared<const vector<int>>(copyEdgeOrder(*graph));
+        entry.first = make_shared<SourceTree>(graph, sourceId, mode, restrictions->getMask(*graph), copyOrder);
+    }
+    shared_ptr<SourceTree> tree = entry.first;
+
+    // trees still used by a query stay alive until it's done
+    size_t bytes = 0;
+    for (auto &cached : sourceTrees) bytes += cached.second.first->getMemoryUsage();
+    while (bytes > MAX_SOURCE_TREE_BYTES && sourceTrees.size() > 1) {
+        auto oldest = sourceTrees.begin();
+        for (auto it = sourceTrees.begin(); it != sourceTrees.end(); it++) {
+            if (it->second.second < oldest->second.second) oldest = it;
+        }
+        bytes -= oldest->second.first->getMemoryUsage();
+        sourceTrees.erase(oldest);
+    }
+    return tree;
+}
+
+
+shared_ptr<const vector<int>> LiveMap::getCopyOrder() {
+    lock_guard<mutex> guard(cacheLock);
+    auto graph = currentSnapshot();
+    if (!copyOrder) copyOrder = make_shared<const vector<int>>(copyEdgeOrder(*graph));
+    return copyOrder;
+}
+
+
+size_t LiveMap::getSourceTreeCount() {
+    lock_guard<mutex> guard(cacheLock);
+    return sourceTrees.size();
+}
+
+
+shared_ptr<const ParkingCatchment> LiveMap::getCatchment() {
+    lock_guard<mutex> guard(cacheLock);
+    auto graph = currentSnapshot();
+
+    // live updates may have changed the walking times
+    if (!catchment || catchment->getVersion() != graph->getVersion()) catchment = make_shared<ParkingCatchment>(graph);
+    return catchment;
+}
+
+
+size_t LiveMap::getParkingCount() {
+    lock_guard<mutex> guard(cacheLock);
+    currentSnapshot();
+    return parkingCount;
+}
+
+
+size_t LiveMap::applyUpdates(const vector<WeightUpdate> &updates) {
+    unique_lock<shared_mutex> exclusive(lock);
+    lock_guard<mutex> guard(cacheLock);
+
+    auto graph = currentSnapshot();
+    const auto &vertices = cityMap->getVertexSet();
+    vector<WeightChange> changes;
+
+    for (auto &u : updates) {
+        int a = graph->findIndex(u.source);
+        int b = graph->findIndex(u.dest);
+        if (a == -1 || b == -1) continue;
+
+        for (auto [x, y] : {make_pair(a, b), make_pair(b, a)}) {
+            for (int e = graph->getFirstEdge(x); e < graph->getFirstEdge(x + 1); e++) {
+                if (graph->getTarget(e) != y) continue;
+
+                // the snapshot keeps the order of the vertices and edges of the map
+                Edge<Location> *edge = vertices[x]->getAdj()[e - graph->getFirstEdge(x)];
+
+                if (u.driving >= 0 && u.driving != edge->getDriving()) {
+                    changes.push_back({x, e, true, edge->getDriving()});
+                    edge->setDriving(u.driving);
+                    graph->setWeight(e, true, u.driving);
+                }
+                if (u.walking >= 0 && u.walking != edge->getWalking()) {
+                    changes.push_back({x, e, false, edge->getWalking()});
+                    edge->setWalking(u.walking);
+                    graph->setWeight(e, false, u.walking);
+                }
+            }
+        }
+    }
+
+    if (changes.empty()) return 0;
+
+    // the snapshot is patched in place and the source trees are repaired; the catchment and the
+    // restriction masks are computed again when used
+    cityMap->touch();
+    graph->setVersion(cityMap->getVersion());
+
+    for (auto it = sourceTrees.begin(); it != sourceTrees.end();) {
+        if (it->second.first->repair(*graph, changes)) it++;
+        else it = sourceTrees.erase(it);
+    }
+
+    return changes.size();
+}
+
+
+bool LiveMap::readUpdates(const string &filename, vector<WeightUpdate> &updates) const {
+    ifstream file(filename);
+
+    if (!file.is_open()) {
+        cerr << "\nError opening updates file: " << filename << endl;
+        return false;
+    }
+
+    unordered_map<string, int> ids;
+    for (auto v : cityMap->getVertexSet()) ids[v->getInfo().getCode()] = v->getInfo().getId();
+
+    auto parseTime = [](const string &value) -> double {
+        if (value.empty() || value == "\r") return -1;      // keep
+        try {return stoi(value);}
+        catch (const invalid_argument &e) {return INF;}     // "X"
+    };
+
+    string line;
+    getline(file, line); // skip header
+
+    while (getline(file, line)) {
+        stringstream ss(line);
+        string loc1, loc2, driv, walk;
+
+        getline(ss, loc1, ',');
+        getline(ss, loc2, ',');
+        getline(ss, driv, ',');
+        getline(ss, walk, ',');
+
+        if (!ids.count(loc1) || !ids.count(loc2)) {
+            cerr << "Unknown segment " << loc1 << "-" << loc2 << " in " << filename << "\n";
+            return false;
+        }
+
+        try {
+            updates.push_back({ids[loc1], ids[loc2], parseTime(driv), parseTime(walk)});
+        } catch (const out_of_range &e) {
+            cerr << "Invalid time for segment " << loc1 << "-" << loc2 << " in " << filename << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+shared_ptr<RestrictionSet> LiveMap::getRestrictions(const vector<int> &avoidNodes, const vector<pair<int, int>> &avoidSegs) {
+    string key = RestrictionSet::canonicalKey(avoidNodes, avoidSegs);
+    restrictionStats().lookups++;
+
+    lock_guard<mutex> guard(restrictionLock);
+    auto &entry = restrictions[key];
+    entry.second = ++restrictionUses;
+    if (entry.first) return entry.first;
+
+    entry.first = make_shared<RestrictionSet>(cityMap, avoidNodes, avoidSegs);
+    restrictionStats().sets++;
+    shared_ptr<RestrictionSet> set = entry.first;
+
+    // sets still used by a query stay alive until it's done
+    if (restrictions.size() > MAX_RESTRICTION_SETS) {
+        auto oldest = restrictions.begin();
+        for (auto it = restrictions.begin(); it != restrictions.end(); it++) {
+            if (it->second.second < oldest->second.second) oldest = it;
+        }
+        restrictions.erase(oldest);
+    }
+    return set;
+}
+
+
+size_t LiveMap::getRestrictionCount() {
+    lock_guard<mutex> guard(restrictionLock);
+    return restrictions.size();
+}
+
+
+size_t LiveMap::getMemoryUsage() {
+    size_t bytes = 0;
+    {
+        lock_guard<mutex> guard(cacheLock);
+        if (snapshot) bytes += snapshot->getMemoryUsage();
+        if (catchment) bytes += catchment->getMemoryUsage();
+        for (auto &entry : sourceTrees) bytes += entry.second.first->getMemoryUsage();
+        if (copyOrder) bytes += copyOrder->capacity() * sizeof(int);
+    }
+
+    lock_guard<mutex> guard(restrictionLock);
+    for (auto &entry : restrictions) bytes += entry.first.size() + entry.second.first->getMemoryUsage();
+    return bytes;
+}
+
+
+static std::map<Graph<Location>*, unique_ptr<LiveMap>> registry;
+static mutex registryLock;
+
+
+LiveMap &liveMap(Graph<Location>* map) {
+    lock_guard<mutex> guard(registryLock);
+    auto &entry = registry[map];
+    if (!entry) entry = make_unique<LiveMap>(map);
+    return *entry;
+}
+
+
+void releaseLiveMap(Graph<Location>* map) {
+    lock_guard<mutex> guard(registryLock);
+    registry.erase(map);
+}
@@ -0,0 +1,219 @@
+/** @file LiveMap.h
+ *  @brief Contains the definition of the LiveMap class.
+ *
+ *  This file defines the LiveMap class, which keeps the data derived from a city map (its compact 
+ *  snapshot, the source trees and the parking catchment) in sync with the map, and applies live changes of 
+ *  segment times to all of them at once.
+ */
+
+#ifndef LIVEMAP_H
+#define LIVEMAP_H
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "SourceTree.h"
+#include "RestrictionSet.h"
+#include "ParkingCatchment.h"
+#include "../data_structures/Graph.h"
+#include "../data_structures/Location.h"
+#include "../data_structures/CompactGraph.h"
+
+using namespace std;
+
+
+/**
+ * @brief A new driving and/or walking time for a segment, in both directions.
+ */
+struct WeightUpdate {
+    int source;         ///< ID of one end of the segment.
+    int dest;           ///< ID of the other end of the segment.
+    double driving;     ///< New driving time (INF if impassable, negative to keep the current one).
+    double walking;     ///< New walking time (INF if impassable, negative to keep the current one).
+};
+
+
+/**
+ * @class LiveMap
+ * @brief Owner of the data derived from a city map, kept consistent under live updates.
+ *
+ * Queries hold the shared side of `getLock()` while they run, and updates hold the exclusive side, 
+ * so a query always sees either all or none of a batch of updates. Updates patch the weights of the 
+ * map and of its compact snapshot in place, without rebuilding the snapshot, and bump the version of 
+ * the map: the source trees are repaired in place (see SourceTree::repair), and the parking catchment 
+ * and the restriction masks are rebuilt on their next use.
+ */
+class LiveMap {
+
+    public:
+        /**
+         * @brief Constructor for LiveMap.
+         * @param map A pointer to the Graph representing the city map.
+         */
+        explicit LiveMap(Graph<Location>* map) : cityMap(map) {}
+
+        /**
+         * @brief Gets the lock that orders queries and updates of the map.
+         * @return The lock (shared for queries, exclusive for updates).
+         */
+        shared_mutex &getLock();
+
+        /**
+         * @brief Gets the lock of the search labels stored in the vertices of the map.
+         * 
+         * Must be held by queries that run `dijkstra` on the map itself instead of on a copy.
+         * 
+         * @return The lock.
+         */
+        mutex &getLabelLock();
+
+        /**
+         * @brief Gets the compact snapshot of the map, building it if the map changed.
+         * 
+         * Must be called while holding the lock.
+         * 
+         * @return The snapshot.
+         */
+        shared_ptr<const CompactGraph<Location>> getSnapshot();
+
+        /**
+         * @brief Gets the lazily grown tree of a source, shared by the queries from it with the same mode and restrictions.
+         * 
+         * Must be called while holding the lock. The trees are repaired by live updates and dropped by 
+         * changes of the structure of the map, and the least recently used ones are dropped when they 
+         * take more than MAX_SOURCE_TREE_BYTES.
+         * 
+         * @param sourceId The ID of the source location.
+         * @param mode The mode of transportation (true for driving, false for walking).
+         * @param restrictions The restrictions of the queries, if any.
+         * @return The tree (whose source may not be in the map, in which case it has no paths).
+         */
+        shared_ptr<SourceTree> getSourceTree(int sourceId, bool mode, shared_ptr<RestrictionSet> restrictions = nullptr);
+
+        /**
+         * @brief Gets the order of the edges of each vertex in a copy of the map made by `copyGraph`.
+         * 
+         * Must be called while holding the lock. Searches of the snapshot with a mask use it to find the 
+         * same paths as `dijkstra` on a pruned copy (see `copyEdgeOrder`).
+         * 
+         * @return The order, computed on first use after the map changed.
+         */
+        shared_ptr<const vector<int>> getCopyOrder();
+
+        /**
+         * @brief Gets the number of source trees currently kept.
+         * @return The number of trees.
+         */
+        size_t getSourceTreeCount();
+
+        /**
+         * @brief Gets the walking catchment of the parking nodes, computing it if the map changed.
+         * Must be called while holding the lock.
+         * @return The catchment of the current snapshot.
+         */
+        shared_ptr<const ParkingCatchment> getCatchment();
+
+        /**
+         * @brief Gets the number of parking nodes of the map, counted once per snapshot.
+         * 
+         * Unlike the other getters, it doesn't need the lock: live updates only change times, not 
+         * which nodes have parking.
+         * 
+         * @return The number of parking nodes.
+         */
+        size_t getParkingCount();
+
+        /**
+         * @brief Applies a batch of segment time changes to the map and everything derived from it.
+         * @param updates The changes.
+         * @return The number of edge weights that changed.
+         */
+        size_t applyUpdates(const vector<WeightUpdate> &updates);
+
+        /**
+         * @brief Reads segment time changes from a CSV file in the format of Distances.csv.
+         * 
+         * "X" marks an impassable segment and an empty value keeps the current time.
+         * 
+         * @param filename The name of the CSV file.
+         * @param updates Vector where the changes are appended.
+         * @return True if the file was read successfully, false otherwise.
+         */
+        bool readUpdates(const string &filename, vector<WeightUpdate> &updates) const;
+
+        /**
+         * @brief Gets the shared set of some restrictions, creating it if it's new.
+         * 
+         * Restrictions with the same nodes and segments, in any order, get the same set. The least 
+         * recently used sets are dropped when there are more than MAX_RESTRICTION_SETS of them.
+         * 
+         * @param avoidNodes IDs of the nodes to avoid.
+         * @param avoidSegs Segments to avoid, as pairs of node IDs (start, end).
+         * @return The set of the restrictions.
+         */
+        shared_ptr<RestrictionSet> getRestrictions(const vector<int> &avoidNodes, const vector<pair<int, int>> &avoidSegs);
+
+        /**
+         * @brief Gets the number of restriction sets currently kept.
+         * @return The number of sets.
+         */
+        size_t getRestrictionCount();
+
+        /**
+         * @brief Computes the number of bytes used by the snapshot, the source trees, the catchment and the restriction sets.
+         * @return The number of bytes used, 0 if nothing was built yet.
+         */
+        size_t getMemoryUsage();
+
+        static const size_t MAX_RESTRICTION_SETS = 64;          ///< Number of restriction sets kept.
+        static const size_t MAX_SOURCE_TREE_BYTES = 64 << 20;   ///< Memory of the source trees kept.
+
+    private:
+        Graph<Location>* cityMap;                           ///< The city map.
+        shared_mutex lock;                                  ///< Orders queries and updates.
+        mutex cacheLock;                                    ///< Protects the snapshot, the source trees and the catchment.
+        mutex labelLock;                                    ///< Protects the labels of the vertices of the map.
+        shared_ptr<CompactGraph<Location>> snapshot;        ///< Compact snapshot of the map.
+        shared_ptr<const ParkingCatchment> catchment;       ///< Walking catchment of the parking nodes.
+        size_t parkingCount = 0;                            ///< Number of parking nodes of the snapshot.
+
+        map<tuple<int, bool, string>, pair<shared_ptr<SourceTree>, unsigned long>> sourceTrees;   ///< Trees by (source ID, mode, restrictions key), with their last use.
+        shared_ptr<const vector<int>> copyOrder;                                ///< Order of the edges in a copy of the map (see `copyEdgeOrder`).
+        unsigned long sourceTreeUses = 0;                                       ///< Number of lookups of source trees.
+
+        mutex restrictionLock;                                                  ///< Protects `restrictions`.
+        unordered_map<string, pair<shared_ptr<RestrictionSet>, unsigned long>> restrictions;   ///< Sets by canonical key, with their last use.
+        unsigned long restrictionUses = 0;                                      ///< Number of lookups of restriction sets.
+
+        /**
+         * @brief Rebuilds the snapshot if the map changed. The cache lock must be held.
+         * @return The current snapshot.
+         */
+        shared_ptr<CompactGraph<Location>> currentSnapshot();
+};
+
+
+/**
+ * @brief Gets the LiveMap of a city map, creating it on first use.
+ * @param map A pointer to the Graph representing the city map.
+ * @return The LiveMap of the map.
+ */
+LiveMap &liveMap(Graph<Location>* map);
+
+/**
+ * @brief Frees the LiveMap of a city map that is about to be deleted.
+ * @param map A pointer to the Graph representing the city map.
+ */
+void releaseLiveMap(Graph<Location>* map);
+
+
+#endif
@@ -0,0 +1,74 @@
+#include "ParkingCatchment.h"
+
+using namespace std;
+
+
+ParkingCatchment::ParkingCatchment(shared_ptr<const CompactGraph<Location>> graph, int k) : graph(graph), version(graph->getVersion()), k(max(1, k)) {
+    TRACE_SCOPE("ParkingCatchment", "search");
+    const CompactGraph<Location> &g = *this->graph;
+    int n = g.getNumVertex();
+
+    count.assign(n, 0);
+    parking.assign((size_t) n * this->k, -1);
+    time.assign((size_t) n * this->k, INF);
+
+    // (walking time, vertex, parking node): each vertex accepts its first k distinct parking nodes
+    typedef tuple<double, int, int> Item;
+    priority_queue<Item, vector<Item>, greater<Item>> pq;
+    for (int v = 0; v < n; v++) {
+        if (g.getInfo(v).hasParking()) pq.push({0.0, v, v});
+    }
+
+    const vector<double> &weights = g.getWeights(false);
+    while (!pq.empty()) {
+        auto [d, v, p] = pq.top();
+        pq.pop();
+
+        size_t first = (size_t) v * this->k;
+        if (count[v] == this->k || find(parking.begin() + first, parking.begin() + first + count[v], p) != parking.begin() + first + count[v]) continue;
+        parking[first + count[v]] = p;
+        time[first + count[v]] = d;
+        count[v]++;
+
+        for (int e = g.getFirstEdge(v); e < g.getFirstEdge(v + 1); e++) {
+            int w = g.getTarget(e);
+            if (weights[e] >= INF || count[w] == this->k) continue;
+            pq.push({d + weights[e], w, p});
+        }
+    }
+}
+
+
+unsigned long ParkingCatchment::getVersion() const {
+    return version;
+}
+
+
+vector<pair<int, double>> ParkingCatchment::getNearest(int id) const {
+    vector<pair<int, double>> res;
+    int v = graph->findIndex(id);
+    if (v == -1) return res;
+
+    for (int i = 0; i < count[v]; i++) {
+        res.push_back({graph->getId(parking[(size_t) v * k + i]), time[(size_t) v * k + i]});
+    }
+    return res;
+}
+
+
+double ParkingCatchment::walkingLowerBound(int parkingId, int id) const {
+    int v = graph->findIndex(id);
+    int p = graph->findIndex(parkingId);
+    if (v == -1 || p == -1) return 0;
+
+    size_t first = (size_t) v * k;
+    for (int i = 0; i < count[v]; i++) {
+        if (parking[first + i] == p) return time[first + i];
+    }
+    return count[v] < k ? INF : time[first + k - 1];
+}
+
+
+size_t ParkingCatchment::getMemoryUsage() const {
+    return sizeof(ParkingCatchment) + count.capacity() * sizeof(int) + parking.capacity() * sizeof(int) + time.capacity() * sizeof(double);
+}
@@ -0,0 +1,87 @@
+/** @file ParkingCatchment.h
+ *  @brief Contains the definition of the ParkingCatchment class.
+ *
+ *  This file defines the walking catchment of the parking nodes of a city map: for every location,
+ *  the parking nodes closest to it on foot. It is computed once per snapshot of the map and lets
+ *  eco routes skip the parking nodes that are too far from the destination before searching.
+ */
+
+#ifndef PARKINGCATCHMENT_H
+#define PARKINGCATCHMENT_H
+
+#include <queue>
+#include <memory>
+#include <vector>
+#include <tuple>
+#include <functional>
+
+#include "SearchStats.h"
+#include "../data_structures/Location.h"
+#include "../data_structures/CompactGraph.h"
+
+using namespace std;
+
+
+/**
+ * @class ParkingCatchment
+ * @brief The k nearest parking nodes of every location, by walking time from the parking node.
+ *
+ * Computed by a single search from all parking nodes at once, where each vertex accepts the labels
+ * of its first k distinct parking nodes. The times are those of the whole map, so they are lower
+ * bounds of the walks of any query, which may avoid nodes, segments or its own driving path.
+ */
+class ParkingCatchment {
+
+    public:
+        static const int DEFAULT_K = 4;     ///< Number of parking nodes kept per location.
+
+        /**
+         * @brief Computes the catchment of a snapshot of the map.
+         * @param graph The snapshot (kept alive by the catchment).
+         * @param k Number of parking nodes to keep per location.
+         */
+        explicit ParkingCatchment(shared_ptr<const CompactGraph<Location>> graph, int k = DEFAULT_K);
+
+        /**
+         * @brief Gets the version of the map the catchment was computed on.
+         *
+         * The snapshot is patched in place by live updates, so this may differ from its current version.
+         *
+         * @return The version of the snapshot when the catchment was computed.
+         */
+        unsigned long getVersion() const;
+
+        /**
+         * @brief Gets the nearest parking nodes of a location.
+         * @param id The ID of the location.
+         * @return Pairs of (parking node ID, walking time from it), nearest first, at most k of them.
+         */
+        vector<pair<int, double>> getNearest(int id) const;
+
+        /**
+         * @brief Gets a lower bound of the walking time from a parking node to a location.
+         * @param parkingId The ID of the parking node.
+         * @param id The ID of the location.
+         * @return The walking time if the parking node is one of the k nearest, the time of the k-th
+         *         nearest if not, INF if the location has fewer than k reachable parking nodes and
+         *         this one isn't among them, 0 if either ID is unknown.
+         */
+        double walkingLowerBound(int parkingId, int id) const;
+
+        /**
+         * @brief Computes the number of bytes used by the catchment, without the snapshot.
+         * @return The number of bytes used.
+         */
+        size_t getMemoryUsage() const;
+
+    private:
+        shared_ptr<const CompactGraph<Location>> graph;     ///< Snapshot the catchment was computed on
+        unsigned long version;                              ///< Version of the snapshot when the catchment was computed
+        int k;                                              ///< Parking nodes kept per location
+        vector<int> count;                                  ///< Number of parking nodes kept for each vertex
+        vector<int> parking;                                ///< Parking nodes of vertex v at [v*k, v*k+count[v]), nearest first
+        vector<double> time;                                ///< Walking time from each of those parking nodes
+};
+
+
+#endif
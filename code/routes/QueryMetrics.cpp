@@ -0,0 +1,219 @@
+#include "QueryMetrics.h"
+#include "RouteCache.h"
+
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+
+// ================================= HISTOGRAM =================================
+
+int LatencyHistogram::bucketOf(uint64_t v) {
+    if (v < (uint64_t) SUB) return v;
+
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - 4;                        // keeps 5 significant bits: 16 <= v >> shift < 32
+    return SUB + (shift - 1) * HALF + (int) ((v >> shift) - HALF);
+}
+
+
+uint64_t LatencyHistogram::upperBound(int bucket) {
+    if (bucket < SUB) return bucket;
+
+    int shift = (bucket - SUB) / HALF + 1;
+    uint64_t sub = (bucket - SUB) % HALF + HALF;
+    return ((sub + 1) << shift) - 1;
+}
+
+
+void LatencyHistogram::record(uint64_t micros) {
+    counts[bucketOf(micros)].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(micros, memory_order_relaxed);
+}
+
+
+uint64_t LatencyHistogram::getCount() const {
+    return count;
+}
+
+
+uint64_t LatencyHistogram::getSum() const {
+    return sum;
+}
+
+
+uint64_t LatencyHistogram::countAtMost(uint64_t micros) const {
+    uint64_t n = 0;
+    for (int b = 0; b < BUCKETS && upperBound(b) <= micros; b++) n += counts[b];
+    return n;
+}
+
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t n = count;
+    if (n == 0) return 0;
+
+    uint64_t rank = max<uint64_t>(1, (uint64_t) (q * n + 0.5));
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += counts[b];
+        if (seen >= rank) return upperBound(b);
+    }
+    return upperBound(BUCKETS - 1);
+}
+
+
+
+
+// ================================= METRICS =================================
+
+QueryMetrics::QueryMetrics() : started(chrono::steady_clock::now()) {}
+
+
+long long QueryMetrics::second() const {
+    return chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - started).count();
+}
+
+
+void QueryMetrics::record(const string &route, const string &outcome, bool cached, double micros) {
+    LatencyHistogram *h;
+    {
+        lock_guard<mutex> guard(lock);
+        auto &entry = histograms[Series(route, outcome, cached)];
+        if (!entry) entry = make_unique<LatencyHistogram>();
+        h = entry.get();
+
+        long long now = second();
+        auto &slot = recent[now % WINDOW];
+        if (slot.first != now) slot = {now, 0};
+        slot.second++;
+    }
+
+    h->record(micros < 0 ? 0 : (uint64_t) micros);
+    total++;
+}
+
+
+void QueryMetrics::writePrometheus(ostream &out) {
+    // bucket bounds of the exported histograms, in seconds
+    static const vector<double> bounds = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 
+                                          0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+    static const vector<double> quantiles = {0.5, 0.9, 0.99, 0.999};
+
+    lock_guard<mutex> guard(lock);
+
+    auto labels = [](const Series &s) {
+        return "route=\"" + get<0>(s) + "\",outcome=\"" + get<1>(s) + "\",cache=\"" + (get<2>(s) ? "hit" : "miss") + "\"";
+    };
+
+    out << setprecision(6);
+
+    out << "# HELP da_route_latency_seconds Latency of route queries.\n";
+    out << "# TYPE da_route_latency_seconds histogram\n";
+    for (auto &[series, h] : histograms) {
+        string l = labels(series);
+        for (double b : bounds) {
+            out << "da_route_latency_seconds_bucket{" << l << ",le=\"" << b << "\"} " << h->countAtMost((uint64_t) (b * 1e6)) << "\n";
+        }
+        out << "da_route_latency_seconds_bucket{" << l << ",le=\"+Inf\"} " << h->getCount() << "\n";
+        out << "da_route_latency_seconds_sum{" << l << "} " << h->getSum() / 1e6 << "\n";
+        out << "da_route_latency_seconds_count{" << l << "} " << h->getCount() << "\n";
+    }
+
+    out << "# HELP da_route_latency_quantile_seconds Latency percentiles of route queries (HDR estimate).\n";
+    out << "# TYPE da_route_latency_quantile_seconds gauge\n";
+    for (auto &[series, h] : histograms) {
+        for (double q : quantiles) {
+            out << "da_route_latency_quantile_seconds{" << labels(series) << ",quantile=\"" << q << "\"} " << h->percentile(q) / 1e6 << "\n";
+        }
+    }
+
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    long long now = second();
+    uint64_t lastWindow = 0;
+    for (auto &slot : recent) {
+        if (slot.first > now - WINDOW) lastWindow += slot.second;
+    }
+    double window = min<double>(WINDOW, elapsed);
+
+    out << "# HELP da_queries_total Route queries processed.\n";
+    out << "# TYPE da_queries_total counter\n";
+    out << "da_queries_total " << total << "\n";
+    out << "# HELP da_queries_per_second Route queries per second, since the start and over the last minute.\n";
+    out << "# TYPE da_queries_per_second gauge\n";
+    out << "da_queries_per_second{window=\"total\"} " << (elapsed > 0 ? total / elapsed : 0) << "\n";
+    out << "da_queries_per_second{window=\"60s\"} " << (window > 0 ? lastWindow / window : 0) << "\n";
+
+    RouteCache &cache = routeCache();
+    size_t hits = cache.getHits(), misses = cache.getMisses();
+    out << "# HELP da_cache_hits_total Route cache lookups answered from the cache.\n";
+    out << "# TYPE da_cache_hits_total counter\n";
+    out << "da_cache_hits_total " << hits << "\n";
+    out << "# HELP da_cache_misses_total Route cache lookups that ran a search.\n";
+    out << "# TYPE da_cache_misses_total counter\n";
+    out << "da_cache_misses_total " << misses << "\n";
+    out << "# HELP da_cache_hit_ratio Fraction of route cache lookups answered from the cache.\n";
+    out << "# TYPE da_cache_hit_ratio gauge\n";
+    out << "da_cache_hit_ratio " << (hits + misses ? (double) hits / (hits + misses) : 0) << "\n";
+    out << "# HELP da_cache_bytes Bytes used by the route cache.\n";
+    out << "# TYPE da_cache_bytes gauge\n";
+    out << "da_cache_bytes " << cache.getBytes() << "\n";
+
+    RestrictionStats &restrictions = restrictionStats();
+    out << "# HELP da_restriction_lookups_total Queries that looked up a restriction set.\n";
+    out << "# TYPE da_restriction_lookups_total counter\n";
+    out << "da_restriction_lookups_total " << restrictions.lookups << "\n";
+    out << "# HELP da_restriction_sets_total Distinct restriction sets created.\n";
+    out << "# TYPE da_restriction_sets_total counter\n";
+    out << "da_restriction_sets_total " << restrictions.sets << "\n";
+    out << "# HELP da_restriction_compiled_total Pruned maps and search masks built for restriction sets.\n";
+    out << "# TYPE da_restriction_compiled_total counter\n";
+    out << "da_restriction_compiled_total{kind=\"graph\"} " << restrictions.graphsBuilt << "\n";
+    out << "da_restriction_compiled_total{kind=\"mask\"} " << restrictions.masksBuilt << "\n";
+    out << "# HELP da_restriction_reused_total Pruned maps and search masks reused instead of being built.\n";
+    out << "# TYPE da_restriction_reused_total counter\n";
+    out << "da_restriction_reused_total{kind=\"graph\"} " << restrictions.graphsReused << "\n";
+    out << "da_restriction_reused_total{kind=\"mask\"} " << restrictions.masksReused << "\n";
+}
+
+
+QueryMetrics &queryMetrics() {
+    static QueryMetrics metrics;
+    return metrics;
+}
+
+
+static mutex fileLock;
+static string metricsFile;
+
+
+void setMetricsFile(const string &filename) {
+    lock_guard<mutex> guard(fileLock);
+    metricsFile = filename;
+}
+
+
+bool dumpMetrics() {
+    lock_guard<mutex> guard(fileLock);
+    if (metricsFile.empty()) return false;
+
+    // written next to the file and renamed, so a scraper never reads half of it
+    string tmp = metricsFile + ".tmp";
+    {
+        ofstream out(tmp);
+        if (!out) {
+            cerr << "Couldn't write the metrics file " << metricsFile << "\n";
+            return false;
+        }
+        queryMetrics().writePrometheus(out);
+    }
+    if (rename(tmp.c_str(), metricsFile.c_str()) != 0) {
+        cerr << "Couldn't write the metrics file " << metricsFile << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,154 @@
+/** @file QueryMetrics.h
+ *  @brief Contains the latency and throughput metrics of route queries.
+ *
+ *  This file defines an HDR-style latency histogram and the QueryMetrics registry, which keeps one
+ *  histogram per route type, outcome and cache result, counts queries per second and exports
+ *  everything, together with the cache hit rate, in the Prometheus text format.
+ */
+
+#ifndef QUERYMETRICS_H
+#define QUERYMETRICS_H
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+using namespace std;
+
+
+/**
+ * @class LatencyHistogram
+ * @brief Histogram of latencies in microseconds with a bounded relative error (HDR-style).
+ *
+ * Values below 32 have a bucket each. Above that, every power of two is split into 16 buckets of 
+ * equal width, so a value is known within about 6% at any magnitude, from microseconds to hours, 
+ * with a fixed number of counters. Recording is lock-free.
+ */
+class LatencyHistogram {
+
+    public:
+        /**
+         * @brief Records a value.
+         * @param micros The latency in microseconds.
+         */
+        void record(uint64_t micros);
+
+        /**
+         * @brief Gets the number of recorded values.
+         * @return The number of values.
+         */
+        uint64_t getCount() const;
+
+        /**
+         * @brief Gets the sum of the recorded values.
+         * @return The sum in microseconds.
+         */
+        uint64_t getSum() const;
+
+        /**
+         * @brief Counts the recorded values known to be at most a bound.
+         * @param micros The bound in microseconds.
+         * @return The number of values in buckets that end at or below the bound.
+         */
+        uint64_t countAtMost(uint64_t micros) const;
+
+        /**
+         * @brief Estimates a percentile.
+         * @param q The quantile, between 0 and 1 (e.g. 0.99).
+         * @return The upper end of the bucket holding the percentile in microseconds, or 0 if empty.
+         */
+        uint64_t percentile(double q) const;
+
+    private:
+        static const int SUB = 32;                          ///< Buckets of exact small values
+        static const int HALF = SUB / 2;                    ///< Buckets per power of two
+        static const int BUCKETS = SUB + 59 * HALF;         ///< Buckets covering every 64-bit value
+
+        array<atomic<uint64_t>, BUCKETS> counts{};          ///< Values in each bucket
+        atomic<uint64_t> count{0};                          ///< Number of values
+        atomic<uint64_t> sum{0};                            ///< Sum of the values
+
+        /**
+         * @brief Finds the bucket of a value.
+         */
+        static int bucketOf(uint64_t v);
+
+        /**
+         * @brief Gets the largest value of a bucket.
+         */
+        static uint64_t upperBound(int bucket);
+};
+
+
+/**
+ * @class QueryMetrics
+ * @brief Latency histograms and throughput of the route queries of the program.
+ */
+class QueryMetrics {
+
+    public:
+        /**
+         * @brief Constructor for QueryMetrics. Throughput is measured from this moment.
+         */
+        QueryMetrics();
+
+        /**
+         * @brief Records a finished query.
+         * @param route The type of route (e.g. "eco").
+         * @param outcome The outcome of the query (see Route::outcome).
+         * @param cached True if the result came from the route cache.
+         * @param micros The latency of the query in microseconds.
+         */
+        void record(const string &route, const string &outcome, bool cached, double micros);
+
+        /**
+         * @brief Writes every metric in the Prometheus text format.
+         * @param out The output stream.
+         */
+        void writePrometheus(ostream &out);
+
+    private:
+        typedef tuple<string, string, bool> Series;     ///< Route, outcome and cache result
+
+        mutex lock;                                                 ///< Protects the maps and the window
+        map<Series, unique_ptr<LatencyHistogram>> histograms;       ///< Histogram of each series
+        chrono::steady_clock::time_point started;                   ///< Start of the measurements
+        atomic<uint64_t> total{0};                                  ///< Number of queries
+
+        static const int WINDOW = 60;                               ///< Seconds of the recent rate
+        array<pair<long long, uint64_t>, WINDOW> recent{};          ///< (second, queries) of the last seconds
+
+        /**
+         * @brief Gets the number of whole seconds since the measurements started.
+         */
+        long long second() const;
+};
+
+
+/**
+ * @brief Gets the metrics shared by all route queries of the program.
+ * @return The global query metrics.
+ */
+QueryMetrics &queryMetrics();
+
+/**
+ * @brief Sets the file where the metrics are dumped by `dumpMetrics`.
+ * @param filename The name of the file ("" to disable the dumps).
+ */
+void setMetricsFile(const string &filename);
+
+/**
+ * @brief Writes the current metrics to the chosen file, replacing its contents.
+ * @return True if the metrics were written, false if no file was set or it couldn't be written.
+ */
+bool dumpMetrics();
+
+
+#endif
@@ -4,18 +4,11 @@
 using namespace std;
 
 
-bool RestrictedRoute::readFromFile(const string &filename) {
-    
-    ifstream inFile(filename);
-
-    if (!inFile ) {
-        cout << "\nError opening files.\n";
-        return false;
-    }
+bool RestrictedRoute::readFromStream(istream &in, const string &filename) {
 
     string line;
 
-    while (getline(inFile, line)) {
+    while (getline(in, line)) {
         stringstream ss(line);
         string key, value, value2;
 
@@ -37,7 +30,7 @@ bool RestrictedRoute::readFromFile(const string &filename) {
                     cout << "Invalid source ID! Must be a positive integer.\n";
                     return false;
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid source ID! Please enter a valid integer.\n";
                 return false;
             } 
@@ -52,82 +45,31 @@ bool RestrictedRoute::readFromFile(const string &filename) {
                     cout << "Invalid destination ID! Must be a positive integer.\n";
                     return false;
                 }
-            } catch (const invalid_argument& e) {
+            } catch (const logic_error& e) {
                 cout << "Invalid destination ID! Please enter a valid integer.\n";
                 return false;
             } 
         } 
 
         else if (key == "AvoidNodes") {
-            if (!value.empty()) {
-                stringstream nodes(value);
-                string node;
-                while (getline(nodes, node, ',')) {
-                    if (!node.empty()) {
-                        try {
-                            int id = stoi(node);  
-                            if (id == source || id == dest) {
-                                cout << "Can't avoid source/dest nodes! Node " << id << " is either the source or destination.\n";
-                            } else {
-                                if (cityMap->findLocationId(id) == nullptr) return false;
-                                else avoidNodes.push_back(id);
-                            }
-                        } catch (const invalid_argument& e) {
-                            cout << "Invalid node ID in 'AvoidNodes' field! Please enter a valid integer for each node.\n";
-                            return false;
-                        }
-                    }
-                }
-            }
+            if (!readAvoidNodes(value, avoidNodes)) return false;
         }
 
         else if (key == "AvoidSegments") {
-            if (!value.empty()) {
-                stringstream segs(value);
-                string seg;
-
-                while (getline(segs, seg, ')')) { 
-
-                    // The segment itself
-                    if (!seg.empty()) {
-        
-                        // "(src,dest" -> "src,dest"
-                        seg.erase(remove(seg.begin(), seg.end(), '('), seg.end());
-        
-                        stringstream pairNodes(seg);
-                        int src, dst;
-                        char comma;
-                
-                        // We extract src and dest
-                        if (pairNodes >> src >> comma >> dst && comma == ',') {
-                            if (cityMap->findLocationId(src) == nullptr || cityMap->findLocationId(dst) == nullptr) return false;
-                            else avoidSegs.push_back(make_pair(src, dst));
-                        } else {
-                            cout << "Invalid segment format.\n";
-                            return false; 
-                        }
-                    }
-        
-                    // The comma separating segments
-                    char separator;
-                    segs >> separator; 
-                }
-            }    
-
+            if (!readAvoidSegments(value, avoidSegs)) return false;
         }
         
-        else if (key == "IncludeNode") {  
-            if (!value.empty()) {
-                try {
-                    int n = stoi(value);
-                    if (cityMap->findLocationId(n) == nullptr) return false;
-                    else node = n;
-                } catch (const invalid_argument& e) {
-                    cout << "Invalid node ID in 'IncludeNode' field! Please enter a valid ID.\n";
-                    return false;
-                }
-            } 
-            else node = -1;  
+        else if (key == "IncludeNode" || key == "IncludeNodes") {  
+            if (!readWaypoints(value)) return false;
+        }
+
+        else if (key == "WaypointOrder") {
+            if (value == "best") bestOrder = true;
+            else if (value == "fixed" || value.empty()) bestOrder = false;
+            else {
+                cout << "Invalid 'WaypointOrder' field! Please enter 'fixed' or 'best'.\n";
+                return false;
+            }
         }
 
         else {
@@ -136,12 +78,32 @@ bool RestrictedRoute::readFromFile(const string &filename) {
         }
     }
 
-    inFile.close();
+    return true;
+}
+
+
+bool RestrictedRoute::readWaypoints(const string &value) {
+    waypoints.clear();
+
+    stringstream nodes(value);
+    string node;
+    while (getline(nodes, node, ',')) {
+        if (node.empty()) continue;
+        try {
+            int n = stoi(node);
+            if (cityMap->findLocationId(n) == nullptr) return false;
+            waypoints.push_back(n);
+        } catch (const logic_error& e) {
+            cout << "Invalid node ID in 'IncludeNode' field! Please enter a valid ID.\n";
+            return false;
+        }
+    }
     return true;
 }
 
 
 void RestrictedRoute::writeToFile(ostream &outFile) {
+    TRACE_SCOPE("RestrictedRoute::writeToFile", "write");
 
     if (cityMap->findLocationId(source) == nullptr) outFile << "Invalid source id! Please enter a node id present in the graph.\n";
     else outFile << "Source:" << source << "\n";
@@ -154,10 +116,7 @@ void RestrictedRoute::writeToFile(ostream &outFile) {
     if (route.empty()) {
         outFile << "none\n";
     } else {
-        for (size_t i = 0; i < route.size(); i++) {
-            outFile << route[i];
-            if (i < route.size() - 1) outFile << ",";
-        }
+        writeIds(outFile, route);
         outFile << "(" << time << ")\n";
     }
 }
@@ -165,58 +124,176 @@ void RestrictedRoute::writeToFile(ostream &outFile) {
 
 
 
-void RestrictedRoute::calculateRoute() {
-    
-    Graph<Location>* copy = copyGraph(cityMap);
+void RestrictedRoute::writeRecord(RecordWriter &out) {
+    TRACE_SCOPE("RestrictedRoute::writeRecord", "write");
+
+    out.beginRecord("restricted");
+    if (cityMap->findLocationId(source) == nullptr) out.none("source");
+    else out.number("source", source);
+    if (cityMap->findLocationId(dest) == nullptr) out.none("destination");
+    else out.number("destination", dest);
+
+    out.path("route", route);
+    if (route.empty()) out.none("time");
+    else out.number("time", time);
+    out.endRecord();
+}
+
+
+
+
+vector<int> RestrictedRoute::getStops() const {
+    vector<int> stops = {source};
+    for (int w : waypoints) {
+        if (w != source && w != dest && find(stops.begin(), stops.end(), w) == stops.end()) stops.push_back(w);
+    }
+    stops.push_back(dest);
+    return stops;
+}
+
+
+bool RestrictedRoute::chainStops(const vector<int> &stops, vector<int> &path, int &total) const {
+    path.clear();
+    total = 0;
 
-    copy->avoidVertices(avoidNodes);
-    copy->avoidEdges(avoidSegs);
+    LiveMap &live = liveMap(cityMap);
+    shared_ptr<RestrictionSet> restrictions = live.getRestrictions(avoidNodes, avoidSegs);
+    auto snapshot = live.getSnapshot();
 
-    if (node!=-1 && node!=source && node!=dest) {
+    // the mask of the restrictions plus the nodes of the legs so far, made for the second leg
+    shared_ptr<SearchMask> used;
 
-        //path from source to mandatory node
-        if (initDijkstra(copy)) dijkstra(copy, source, node, 1);
-        vector<int> route1 = getPath(copy, source, node);
-        Vertex<Location> *nodeVertex = copy->findLocationId(node);
-        int time1 = nodeVertex->getDist();
+    for (size_t i = 0; i + 1 < stops.size(); i++) {
+        int from = stops[i], to = stops[i + 1];
+
+        //path from this stop to the next one; the first leg comes from the tree of the source,
+        //shared with other queries with the same restrictions
+        double dist;
+        vector<int> leg;
+        if (i == 0) leg = live.getSourceTree(from, true, restrictions)->getPath(to, dist);
+        else leg = SourceTree(snapshot, from, true, used, live.getCopyOrder()).getPath(to, dist);
+
+        //impossible path between two stops
+        if (leg.empty()) return false;
+
+        int legTime = dist;
+        total += legTime;
 
         //avoid repetition of nodes
-        route1.pop_back();
-        copy->avoidVertices(route1);
-        
-        //path from mandatory node to destination
-        if (initDijkstra(copy)) dijkstra(copy, node, dest, 1);
-        vector<int> route2 = getPath(copy, node, dest);
-        Vertex<Location> *destVertex = copy->findLocationId(dest);
-        int time2 = destVertex->getDist();
-
-        //impossible path from mandatory node to destination
-        if(route1.empty() || route2.empty()) {
-            delete copy;
-            return;
+        if (i + 2 < stops.size()) {
+            leg.pop_back();
+            if (!used) {
+                used = make_shared<SearchMask>(*restrictions->getMask(*snapshot));
+                if (used->blockedVertex.empty()) used->blockedVertex.assign(snapshot->getNumVertex(), 0);
+            }
+            for (int id : leg) used->blockedVertex[snapshot->findIndex(id)] = 1;
         }
 
-        //combination of the two results
-        route1.insert(route1.end(), route2.begin(), route2.end()); 
-        route = route1; 
-        time = time1 + time2;
+        //combination of the results
+        path.insert(path.end(), leg.begin(), leg.end());
+    }
 
-    } else {
-        if (initDijkstra(copy)) dijkstra(copy, source, dest, 1);
-        route = getPath(copy, source, dest);
-        Vertex<Location> *destVertex = copy->findLocationId(dest);
-        time = destVertex->getDist();
+    return true;
+}
+
+
+vector<int> RestrictedRoute::orderStops(const vector<int> &stops) const {
+    LiveMap &live = liveMap(cityMap);
+    auto snapshot = live.getSnapshot();
+    const CompactGraph<Location> &compact = *snapshot;
+    shared_ptr<const SearchMask> mask = live.getRestrictions(avoidNodes, avoidSegs)->getMask(compact);
+
+    size_t n = stops.size();
+    vector<int> index;
+    for (int id : stops) {
+        index.push_back(compact.findIndex(id));
+        if (index.back() == -1) return stops;
+    }
+
+    // travel times between the stops, from one search from every stop but the destination (nothing leaves it)
+    vector<vector<double>> cost(n, vector<double>(n, INF));
+    {
+        PhaseTimer phase("legs");
+        SearchLabels labels;
+        SweepOptions options;
+        options.mask = mask.get();
+        options.targets = index;
+
+        for (size_t i = 0; i + 1 < n; i++) {
+            sweep(compact, index[i], true, labels, options);
+            for (size_t j = 0; j < n; j++) cost[i][j] = labels.dist[index[j]];
+        }
     }
 
+    PhaseTimer phase("order");
+    vector<int> ordered = {stops[0]};
+    for (int w : bestWaypointOrder(cost)) ordered.push_back(stops[w]);
+    ordered.push_back(stops[n - 1]);
+    return ordered;
+}
+
+
+void RestrictedRoute::calculateRoute() {
+
+    route.clear();
+    time = 0;
 
-    //avoid mem leak
-    delete copy;
+    vector<int> stops = getStops();
+    vector<int> path;
+    int total;
+
+    if (bestOrder && stops.size() > 3) stops = orderStops(stops);
+
+    if (chainStops(stops, path, total)) {
+        route = path;
+        time = total;
+    }
 }
 
 
 
 
 void RestrictedRoute::processRoute(ostream &outFile) {
-    calculateRoute();
-    writeToFile(outFile);    
-}
\ No newline at end of file
+    {
+        PhaseTimer phase("route");
+        calculateRoute();
+    }
+    PhaseTimer phase("write");
+    writeResult(outFile);    
+}
+
+
+string RestrictedRoute::queryKey() const {
+    ostringstream key;
+    key << "restricted|" << mode << "|" << source << "|" << dest << "|" << canonicalRestrictions(avoidNodes, avoidSegs) << "|";
+
+    // waypoints that are the source or the destination are the same as none
+    vector<int> stops = getStops();
+    vector<int> inner(stops.begin() + 1, stops.end() - 1);
+    if (inner.empty()) key << -1;
+
+    // with the best order, the order they were given in doesn't matter
+    if (bestOrder && inner.size() > 1) sort(inner.begin(), inner.end());
+    for (size_t i = 0; i < inner.size(); i++) {
+        key << inner[i];
+        if (i < inner.size() - 1) key << ",";
+    }
+    if (bestOrder && inner.size() > 1) key << "|best";
+    return key.str();
+}
+
+
+string RestrictedRoute::outcome() const {
+    return route.empty() ? "none" : "found";
+}
+
+
+string RestrictedRoute::reuseKey() const {
+    return to_string(source) + "|driving|" + canonicalRestrictions(avoidNodes, avoidSegs);
+}
+
+
+double RestrictedRoute::estimateCost() const {
+    size_t stops = getStops().size();
+    return bestOrder && stops > 3 ? 2 * stops - 2 : stops - 1;
+}
@@ -2,7 +2,7 @@
  *  @brief Contains the definition of the RestrictedRoute class.
  *
  *  This file defines the RestrictedRoute class, which calculates a route between a source and destination on a given map.
- *  The class allows users to impose specific routing restrictions, such as avoiding certain nodes or road segments and ensuring the inclusion of a specific node.
+ *  The class allows users to impose specific routing restrictions, such as avoiding certain nodes or road segments and ensuring the inclusion of some nodes (waypoints).
  *  It provides flexibility to control the route based on user-defined constraints.
  */
 
@@ -11,6 +11,9 @@
 
 
 #include "Route.h"
+#include "sweep.h"
+#include "LiveMap.h"
+#include "waypoints.h"
 
 using namespace std;
 
@@ -23,6 +26,10 @@ using namespace std;
  * It enables users to avoid undesirable road segments, excluding specific segments from the graph.
  * It enables users to simultaneously exclude the combination of nodes and segments of the graph.
  * It enables users to include a single specific node (or stop) that the route must include while ensuring that the calculated route remains the fastest possible
+ * It enables users to include several nodes, visited in the given order or in the order that makes the route fastest.
+ * The order is chosen from the travel times between the waypoints, computed once (exactly for up to EXACT_WAYPOINT_LIMIT waypoints,
+ * heuristically for more).
+ * With any number of waypoints, the route never visits a node twice: each leg avoids the nodes of the legs before it.
  */
 class RestrictedRoute : public Route {
 
@@ -35,13 +42,13 @@ class RestrictedRoute : public Route {
          * 
          * @param map A pointer to the Graph representing the map with locations.
          */
-        RestrictedRoute(Graph<Location>* map) : Route(map,"",-1,-1), avoidNodes(), avoidSegs(), node(-1), time(0), route() {}
+        RestrictedRoute(Graph<Location>* map) : Route(map,"",-1,-1), avoidNodes(), avoidSegs(), waypoints(), bestOrder(false), time(0), route() {}
 
         /**
          * @brief Constructor for RestrictedRoute with specific mode, source, destination, and restrictions.
          * 
          * Initializes a RestrictedRoute object with the provided parameters, setting up restrictions
-         * on nodes and segments, as well as the node where the route must end.
+         * on nodes and segments, as well as the nodes the route must include.
          * 
          * @param map A pointer to the Graph representing the map with locations.
          * @param m A string representing the mode of transportation ("driving", "driving-walking").
@@ -49,17 +56,19 @@ class RestrictedRoute : public Route {
          * @param dt The ID of the destination location.
          * @param avoidN A vector of node IDs to avoid during the route calculation.
          * @param avoidS A vector of pairs representing edge segments to avoid (start, end).
-         * @param inc The ID of a node to include on the path.
+         * @param inc The IDs of the nodes to include on the path.
+         * @param best True to visit the nodes to include in the fastest order, false to keep their order.
          */    
-        RestrictedRoute(Graph<Location>* map, string m, int src, int dt, vector<int> avoidN, vector<pair<int, int>> avoidS, int inc) 
-            :  Route(map,m,src,dt), avoidNodes(avoidN), avoidSegs(avoidS), node(inc), time(0), route() {}
+        RestrictedRoute(Graph<Location>* map, string m, int src, int dt, vector<int> avoidN, vector<pair<int, int>> avoidS, vector<int> inc, bool best = false) 
+            :  Route(map,m,src,dt), avoidNodes(avoidN), avoidSegs(avoidS), waypoints(inc), bestOrder(best), time(0), route() {}
         
         /**
-         * @brief Reads route data from a file.
-         * @param filename Name of the file to read from.
+         * @brief Reads route data from a stream of 'Key:value' lines.
+         * @param in The stream to read from.
+         * @param filename Name of the input, used in error messages.
          * @return True if reading was successful, false otherwise.
          */
-        bool readFromFile(const string &filename) override;
+        bool readFromStream(istream &in, const string &filename) override;
 
         /**
          * @brief Writes route data to an output stream.
@@ -67,6 +76,12 @@ class RestrictedRoute : public Route {
          */
         void writeToFile(ostream &outFile) override;
 
+        /**
+         * @brief Writes the route data as a record, for the JSON Lines and binary formats.
+         * @param out The writer of the record.
+         */
+        void writeRecord(RecordWriter &out) override;
+
         /**
          * @brief Calculates the route while avoiding certain nodes and edges.
          * 
@@ -82,14 +97,83 @@ class RestrictedRoute : public Route {
          */
         void processRoute(ostream &outFile) override;
 
+        /**
+         * @brief Builds the canonical key of this query, used by the route cache.
+         * @return The canonical query key.
+         */
+        string queryKey() const override;
+
+        /**
+         * @brief Classifies the result of the last processing, for the query metrics.
+         * @return "found" or "none".
+         */
+        string outcome() const override;
+
+        /**
+         * @brief Builds the key of the searches that this query may share with other queries.
+         * @return The source, the driving mode and the restrictions.
+         */
+        string reuseKey() const override;
+
+        /**
+         * @brief Estimates the work of processing this route, to schedule the longest queries first.
+         * @return One search per leg, and one per stop but the last to choose the best order.
+         */
+        double estimateCost() const override;
+
 
     private:
         vector<int> avoidNodes;  ///< Vector of node IDs to avoid during the route calculation.
         vector<pair<int, int>> avoidSegs;  ///< Vector of edge segments to avoid, represented as pairs of node IDs (start, end).
-        int node;  ///< The ID of the node that needs to be included.
+        vector<int> waypoints;  ///< The IDs of the nodes that need to be included.
+        bool bestOrder;  ///< True to visit the waypoints in the fastest order, false to keep their order.
         int time;  ///< The total time for the calculated route.
         vector<int> route;  ///< Vector holding the IDs of the vertices in the calculated route.
 
+        /**
+         * @brief Reads a comma separated list of waypoints.
+         * @param value The list of node IDs.
+         * @return True if every ID is in the map, false otherwise.
+         */
+        bool readWaypoints(const string &value);
+
+        /**
+         * @brief Gets the stops of the route: the source, the waypoints and the destination.
+         * 
+         * Waypoints that are the source, the destination or repeated are left out.
+         * 
+         * @return The IDs of the stops, in the given order.
+         */
+        vector<int> getStops() const;
+
+        /**
+         * @brief Builds the route through the stops, one leg at a time.
+         * 
+         * The legs are searched on the snapshot of the map (see LiveMap). The first one comes from the 
+         * shared tree of the source, and the others avoid, on top of the mask of the restrictions, the 
+         * nodes of the legs before them, so the route never visits a node twice, whatever the number 
+         * of waypoints. The shared restrictions aren't changed.
+         * 
+         * @param stops The stops, in the order they are visited.
+         * @param path Set to the IDs of the vertices of the route.
+         * @param total Set to the total time of the route.
+         * @return True if every leg was possible, false otherwise.
+         */
+        bool chainStops(const vector<int> &stops, vector<int> &path, int &total) const;
+
+        /**
+         * @brief Chooses the fastest order of the waypoints.
+         * 
+         * The travel times between every pair of stops are computed with one search from each stop on the 
+         * snapshot of the map (see LiveMap), honoring the nodes and segments to avoid, and the order is 
+         * chosen from them (see waypoints.h). The times don't account for the nodes that earlier legs 
+         * take away from later ones, so the route in that order may still be impossible.
+         * 
+         * @param stops The stops, in the given order.
+         * @return The stops in the order found, from the source to the destination.
+         */
+        vector<int> orderStops(const vector<int> &stops) const;
+
 };
 
 
@@ -0,0 +1,113 @@
+#include "RestrictionSet.h"
+
+using namespace std;
+
+
+RestrictionStats &restrictionStats() {
+    static RestrictionStats stats;
+    return stats;
+}
+
+
+string RestrictionSet::canonicalKey(vector<int> nodes, vector<pair<int, int>> segs) {
+    sort(nodes.begin(), nodes.end());
+    nodes.erase(unique(nodes.begin(), nodes.end()), nodes.end());
+    sort(segs.begin(), segs.end());
+    segs.erase(unique(segs.begin(), segs.end()), segs.end());
+
+    ostringstream out;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        out << nodes[i];
+        if (i < nodes.size() - 1) out << ",";
+    }
+    out << "|";
+    for (auto &s : segs) out << "(" << s.first << "," << s.second << ")";
+    return out.str();
+}
+
+
+RestrictionSet::RestrictionSet(Graph<Location>* map, vector<int> nodes, vector<pair<int, int>> segs) : cityMap(map) {
+    sort(nodes.begin(), nodes.end());
+    nodes.erase(unique(nodes.begin(), nodes.end()), nodes.end());
+    sort(segs.begin(), segs.end());
+    segs.erase(unique(segs.begin(), segs.end()), segs.end());
+
+    this->nodes = move(nodes);
+    this->segs = move(segs);
+    key = canonicalKey(this->nodes, this->segs);
+}
+
+
+RestrictionSet::~RestrictionSet() {
+    for (auto g : idle) delete g;
+}
+
+
+RestrictionSet::Lease::~Lease() {
+    if (graph) set->giveBack(graph, version);
+}
+
+
+RestrictionSet::Lease RestrictionSet::lease() {
+    unsigned long current = cityMap->getVersion();
+    {
+        lock_guard<mutex> guard(lock);
+
+        // built before the map changed
+        if (version != current) {
+            for (auto g : idle) delete g;
+            idle.clear();
+            version = current;
+        }
+
+        if (!idle.empty()) {
+            Graph<Location>* graph = idle.back();
+            idle.pop_back();
+            restrictionStats().graphsReused++;
+            return Lease(shared_from_this(), graph, current);
+        }
+    }
+
+    // removing vertices and edges doesn't depend on the order they are removed in,
+    // so this is the same as pruning with the restrictions in the order they were given
+    Graph<Location>* graph = timedCopyGraph(cityMap);
+    graph->avoidVertices(nodes);
+    graph->avoidEdges(segs);
+    restrictionStats().graphsBuilt++;
+    return Lease(shared_from_this(), graph, current);
+}
+
+
+void RestrictionSet::giveBack(Graph<Location>* graph, unsigned long graphVersion) {
+    lock_guard<mutex> guard(lock);
+    if (graphVersion == version && graphVersion == cityMap->getVersion()) idle.push_back(graph);
+    else delete graph;
+}
+
+
+shared_ptr<const SearchMask> RestrictionSet::getMask(const CompactGraph<Location> &g) {
+    lock_guard<mutex> guard(lock);
+    if (mask && maskVersion == g.getVersion()) {
+        restrictionStats().masksReused++;
+        return mask;
+    }
+
+    mask = make_shared<SearchMask>(makeMask(g, nodes, segs));
+    maskVersion = g.getVersion();
+    restrictionStats().masksBuilt++;
+    return mask;
+}
+
+
+const string &RestrictionSet::getKey() const {
+    return key;
+}
+
+
+size_t RestrictionSet::getMemoryUsage() {
+    lock_guard<mutex> guard(lock);
+    size_t bytes = sizeof(RestrictionSet) + nodes.capacity() * sizeof(int) + segs.capacity() * sizeof(pair<int, int>);
+    for (auto g : idle) bytes += g->getMemoryUsage();
+    if (mask) bytes += mask->blockedVertex.capacity() + mask->blockedEdge.capacity();
+    return bytes;
+}
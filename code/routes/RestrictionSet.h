@@ -0,0 +1,175 @@
+/** @file RestrictionSet.h
+ *  @brief Contains the definition of the RestrictionSet class.
+ *
+ *  This file defines a canonical set of nodes and segments to avoid, which is compiled once
+ *  for a city map and then shared by every query that uses the same restrictions (e.g. all the
+ *  queries of a batch that avoid the same closed streets).
+ */
+
+#ifndef RESTRICTIONSET_H
+#define RESTRICTIONSET_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+
+#include "sweep.h"
+#include "SearchStats.h"
+#include "../data_structures/Graph.h"
+#include "../data_structures/Location.h"
+#include "../data_structures/CompactGraph.h"
+
+using namespace std;
+
+
+/**
+ * @brief How often compiled restrictions were reused, over the whole program.
+ */
+struct RestrictionStats {
+    atomic<unsigned long> lookups{0};       ///< Queries that asked for a restriction set.
+    atomic<unsigned long> sets{0};          ///< Distinct restriction sets created.
+    atomic<unsigned long> graphsBuilt{0};   ///< Pruned copies of the map built.
+    atomic<unsigned long> graphsReused{0};  ///< Pruned copies leased again instead of being built.
+    atomic<unsigned long> masksBuilt{0};    ///< Search masks built.
+    atomic<unsigned long> masksReused{0};   ///< Search masks shared instead of being built.
+};
+
+
+/**
+ * @brief Gets the reuse counters of all restriction sets.
+ * @return The global counters.
+ */
+RestrictionStats &restrictionStats();
+
+
+/**
+ * @class RestrictionSet
+ * @brief Nodes and segments to avoid on a city map, compiled on demand and shared between queries.
+ *
+ * The restrictions are kept sorted and without duplicates, so sets given in any order are the same
+ * set (see LiveMap::getRestrictions, which interns them). A set compiles into:
+ * - pruned copies of the map, without the avoided nodes and segments, for the searches that run
+ *   `dijkstra` on a Graph. A copy is leased to one query at a time and goes back to the set when
+ *   the query is done, so the set keeps as many copies as queries ever used it at once.
+ * - a SearchMask over the compact snapshot of the map, for the searches of sweep.h.
+ *
+ * Both are built again when the map changes.
+ */
+class RestrictionSet : public enable_shared_from_this<RestrictionSet> {
+
+    public:
+        /**
+         * @class Lease
+         * @brief Exclusive use of a pruned copy of the map, returned to its set on destruction.
+         */
+        class Lease {
+            public:
+                /**
+                 * @brief Constructor for Lease.
+                 * @param set The set the copy belongs to.
+                 * @param graph The pruned copy.
+                 * @param version The version of the map the copy was built from.
+                 */
+                Lease(shared_ptr<RestrictionSet> set, Graph<Location>* graph, unsigned long version)
+                    : set(set), graph(graph), version(version) {}
+
+                Lease(Lease &&other) noexcept : set(move(other.set)), graph(other.graph), version(other.version) { other.graph = nullptr; }
+
+                Lease(const Lease &) = delete;
+                Lease &operator=(const Lease &) = delete;
+                Lease &operator=(Lease &&) = delete;
+
+                /**
+                 * @brief Returns the copy to its set.
+                 */
+                ~Lease();
+
+                /**
+                 * @brief Gets the pruned copy. Its search labels may be changed freely.
+                 * @return A pointer to the copy.
+                 */
+                Graph<Location>* get() const { return graph; }
+
+            private:
+                shared_ptr<RestrictionSet> set;     ///< The set the copy belongs to
+                Graph<Location>* graph;             ///< The pruned copy
+                unsigned long version;              ///< Version of the map the copy was built from
+        };
+
+        /**
+         * @brief Constructor for RestrictionSet. Nothing is compiled yet.
+         * @param map A pointer to the Graph representing the city map.
+         * @param nodes IDs of the nodes to avoid.
+         * @param segs Segments to avoid, as pairs of node IDs (start, end).
+         */
+        RestrictionSet(Graph<Location>* map, vector<int> nodes, vector<pair<int, int>> segs);
+
+        /**
+         * @brief Destructor for RestrictionSet. Frees the idle copies.
+         */
+        ~RestrictionSet();
+
+        RestrictionSet(const RestrictionSet &) = delete;
+        RestrictionSet &operator=(const RestrictionSet &) = delete;
+
+        /**
+         * @brief Leases a pruned copy of the map, building one if none is idle.
+         * @return The lease of the copy.
+         */
+        Lease lease();
+
+        /**
+         * @brief Gets the mask of the restrictions on a snapshot of the map, building it if needed.
+         * @param g The snapshot.
+         * @return The mask.
+         */
+        shared_ptr<const SearchMask> getMask(const CompactGraph<Location> &g);
+
+        /**
+         * @brief Gets the canonical form of the restrictions.
+         * @return The canonical key (see `canonicalKey`).
+         */
+        const string &getKey() const;
+
+        /**
+         * @brief Computes the number of bytes used by the idle copies and the mask.
+         * @return The number of bytes used.
+         */
+        size_t getMemoryUsage();
+
+        /**
+         * @brief Formats a set of restrictions in canonical form (sorted, without duplicates).
+         *
+         * @param nodes IDs of the nodes to avoid.
+         * @param segs Segments to avoid, as pairs of node IDs (start, end).
+         * @return The canonical representation, e.g. "2,7|(4,7)".
+         */
+        static string canonicalKey(vector<int> nodes, vector<pair<int, int>> segs);
+
+    private:
+        Graph<Location>* cityMap;               ///< The city map.
+        vector<int> nodes;                      ///< Nodes to avoid, sorted.
+        vector<pair<int, int>> segs;            ///< Segments to avoid, sorted.
+        string key;                             ///< Canonical key of the set.
+
+        mutex lock;                             ///< Protects the copies and the mask.
+        unsigned long version = 0;              ///< Version of the map the idle copies were built from.
+        vector<Graph<Location>*> idle;          ///< Pruned copies not leased to any query.
+        shared_ptr<SearchMask> mask;            ///< Mask on the snapshot, if built.
+        unsigned long maskVersion = 0;          ///< Version of the snapshot the mask was built for.
+
+        /**
+         * @brief Takes a copy back from a lease, keeping it if the map didn't change meanwhile.
+         * @param graph The copy.
+         * @param graphVersion The version of the map the copy was built from.
+         */
+        void giveBack(Graph<Location>* graph, unsigned long graphVersion);
+};
+
+
+#endif
@@ -0,0 +1,99 @@
+#include "Route.h"
+
+using namespace std;
+
+
+bool Route::readFromFile(const string &filename) {
+
+    ifstream inFile(filename);
+
+    if (!inFile ) {
+        cout << "\nError opening files.\n";
+        return false;
+    }
+
+    return readFromStream(inFile, filename);
+}
+
+
+void Route::writeResult(ostream &outFile) {
+    unique_ptr<RecordWriter> records = makeRecordWriter(getOutputFormat());
+    if (!records) {
+        writeToFile(outFile);
+        return;
+    }
+
+    writeRecord(*records);
+    outFile.write(records->data().data(), records->data().size());
+}
+
+
+string Route::reuseKey() const {
+    return to_string(source) + "|" + mode;
+}
+
+
+double Route::estimateCost() const {
+    return 1;
+}
+
+
+bool Route::readAvoidNodes(const string &value, vector<int> &avoidNodes) const {
+    if (!value.empty()) {
+        stringstream nodes(value);
+        string node;
+        while (getline(nodes, node, ',')) {
+            if (!node.empty()) {
+                try {
+                    int id = stoi(node);  
+                    if (id == source || id == dest) {
+                        cout << "Can't avoid source/dest nodes! Node " << id << " is either the source or destination.\n";
+                    } else {
+                        if (cityMap->findLocationId(id) == nullptr) return false;
+                        else avoidNodes.push_back(id);
+                    }
+                } catch (const logic_error& e) {
+                    cout << "Invalid node ID in 'AvoidNodes' field! Please enter a valid integer for each node.\n";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+bool Route::readAvoidSegments(const string &value, vector<pair<int, int>> &avoidSegs) const {
+    if (!value.empty()) {
+        stringstream segs(value);
+        string seg;
+
+        while (getline(segs, seg, ')')) { 
+
+            // The segment itself
+            if (!seg.empty()) {
+
+                // "(src,dest" -> "src,dest"
+                seg.erase(remove(seg.begin(), seg.end(), '('), seg.end());
+
+                stringstream pairNodes(seg);
+                int src, dst;
+                char comma;
+        
+                // We extract src and dest
+                if (pairNodes >> src >> comma >> dst && comma == ',') {
+                    if (cityMap->findLocationId(src) == nullptr || cityMap->findLocationId(dst) == nullptr) return false;
+                    else avoidSegs.push_back(make_pair(src, dst));
+                } else {
+                    cout << "Invalid segment format.\n";
+                    return false; 
+                }
+            }
+
+            // The comma separating segments
+            char separator;
+            segs >> separator; 
+        }
+    }
+    return true;
+}
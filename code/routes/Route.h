@@ -26,6 +26,8 @@
 #include "../data_structures/Graph.h"
 #include "../data_structures/Location.h"
 #include "dijkstra.h"
+#include "RestrictionSet.h"
+#include "../processors/writer.h"
 
 using namespace std;
 
@@ -62,13 +64,25 @@ class Route {
         /**
          * @brief Reads the route data from a file.
          * 
-         * This is a pure virtual function, which must be implemented in derived classes to 
-         * handle reading the route information from a file.
+         * Opens the file and reads it with `readFromStream`.
          * 
          * @param filename The name of the file to read.
          * @return True if reading was successful, false otherwise.
          */
-        virtual bool readFromFile(const string &filename) = 0;
+        bool readFromFile(const string &filename);
+
+        /**
+         * @brief Reads the route data from a stream of 'Key:value' lines, as found in input files.
+         * 
+         * This is a pure virtual function, which must be implemented in derived classes to 
+         * handle reading the route information, whether it comes from a file or from a client 
+         * of the routing server.
+         * 
+         * @param in The stream to read from, until its end.
+         * @param filename Name of the input, used in error messages.
+         * @return True if reading was successful, false otherwise.
+         */
+        virtual bool readFromStream(istream &in, const string &filename) = 0;
 
 
         /**
@@ -81,6 +95,25 @@ class Route {
          */        
         virtual void writeToFile(ostream &outFile) = 0;
 
+        /**
+         * @brief Writes the route data as a record, for the JSON Lines and binary formats.
+         * 
+         * This is a pure virtual function, which must be implemented in derived classes to 
+         * write the same information as `writeToFile`, as named fields (see writer.h).
+         * 
+         * @param out The writer of the record.
+         */
+        virtual void writeRecord(RecordWriter &out) = 0;
+
+        /**
+         * @brief Writes the route data in the chosen output format (see `setOutputFormat`).
+         * 
+         * Uses `writeToFile` for the text format and `writeRecord` for the others.
+         * 
+         * @param outFile The output stream to write the data to.
+         */
+        void writeResult(ostream &outFile);
+
 
         /**
          * @brief Processes the route, which may involve calculations, optimizations, or other actions.
@@ -91,12 +124,85 @@ class Route {
          * @param outFile The output stream to which results will be written.
          */    
         virtual void processRoute(ostream &outFile) = 0;
+
+        /**
+         * @brief Builds a canonical description of the query represented by this route.
+         * 
+         * Two routes with the same key produce the same output on the same map, regardless of the 
+         * order in which their restrictions were given. Used as the key of the `RouteCache`.
+         * 
+         * @return The canonical query key.
+         */
+        virtual string queryKey() const = 0;
+
+        /**
+         * @brief Classifies the result of the last call to `processRoute`, for the query metrics.
+         * 
+         * @return "found" if a route was found, "approximate" if only approximate solutions 
+         * were found, or "none".
+         */
+        virtual string outcome() const = 0;
+
+        /**
+         * @brief Builds the key of the searches that this query may share with other queries.
+         * 
+         * Queries with the same key start from the same source with the same mode and restrictions, 
+         * so they reuse the same source trees and restriction masks (see LiveMap). Used to keep 
+         * them together when a batch is scheduled.
+         * 
+         * @return The reuse key (the source and the mode, unless overridden).
+         */
+        virtual string reuseKey() const;
+
+        /**
+         * @brief Estimates the work of processing this route, to schedule the longest queries first.
+         * 
+         * @return The estimated cost, in searches over the whole map (1 unless overridden).
+         */
+        virtual double estimateCost() const;
+
+        /**
+         * @brief Gets the map used by this route.
+         * @return A pointer to the Graph representing the city map.
+         */
+        Graph<Location>* getMap() const { return cityMap; }
     
     protected:
         Graph<Location>* cityMap; ///< Pointer to the graph representing the city map with locations.
         string mode;              ///< Mode of transportation (e.g., "driving" or "driving-walking").
         int source;               ///< ID of the source location.
         int dest;                 ///< ID of the destination location.
+
+        /**
+         * @brief Parses the value of an 'AvoidNodes' field (e.g. "2,7").
+         * 
+         * IDs equal to the source or destination are ignored with a warning.
+         * 
+         * @param value The comma separated list of node IDs.
+         * @param avoidNodes Vector where the IDs are appended.
+         * @return True if every ID is valid and present in the map, false otherwise.
+         */
+        bool readAvoidNodes(const string &value, vector<int> &avoidNodes) const;
+
+        /**
+         * @brief Parses the value of an 'AvoidSegments' field (e.g. "(1,2),(4,7)").
+         * 
+         * @param value The comma separated list of segments.
+         * @param avoidSegs Vector where the segments are appended, as pairs of node IDs (start, end).
+         * @return True if every segment is valid and its nodes are present in the map, false otherwise.
+         */
+        bool readAvoidSegments(const string &value, vector<pair<int, int>> &avoidSegs) const;
+
+        /**
+         * @brief Formats a set of restrictions in canonical form (sorted, without duplicates).
+         * 
+         * @param nodes IDs of the nodes to avoid.
+         * @param segs Segments to avoid, as pairs of node IDs (start, end).
+         * @return The canonical representation, e.g. "2,7|(4,7)".
+         */
+        static string canonicalRestrictions(const vector<int> &nodes, const vector<pair<int, int>> &segs) {
+            return RestrictionSet::canonicalKey(nodes, segs);
+        }
 };
 
 #endif // ROUTE_H
@@ -0,0 +1,153 @@
+#include "RouteCache.h"
+
+using namespace std;
+
+
+RouteCache::RouteCache(size_t budget, size_t numShards) : shardBudget(budget / max<size_t>(numShards, 1)) {
+    for (size_t i = 0; i < max<size_t>(numShards, 1); i++) {
+        shards.push_back(make_unique<Shard>());
+    }
+}
+
+
+RouteCache::Shard &RouteCache::shardFor(const string &key) {
+    return *shards[hash<string>()(key) % shards.size()];
+}
+
+
+size_t RouteCache::entrySize(const Entry &e) {
+    // key is stored twice (entry and index)
+    return sizeof(Entry) + 2 * e.key.size() + e.result.size() + e.outcome.size();
+}
+
+
+void RouteCache::erase(Shard &shard, list<Entry>::iterator it) {
+    shard.bytes -= entrySize(*it);
+    shard.index.erase(it->key);
+    shard.lru.erase(it);
+}
+
+
+bool RouteCache::lookup(const string &key, unsigned long version, string &result, string &outcome) {
+    Shard &shard = shardFor(key);
+    lock_guard<mutex> lock(shard.lock);
+
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        misses++;
+        return false;
+    }
+
+    auto it = found->second;
+
+    // computed on an older map
+    if (it->version != version) {
+        erase(shard, it);
+        misses++;
+        return false;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it);
+    result = it->result;
+    outcome = it->outcome;
+    hits++;
+    return true;
+}
+
+
+void RouteCache::insert(const string &key, unsigned long version, const string &result, const string &outcome) {
+    Shard &shard = shardFor(key);
+    lock_guard<mutex> lock(shard.lock);
+
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) erase(shard, found->second);
+
+    Entry e = {key, version, result, outcome};
+    size_t size = entrySize(e);
+    if (size > shardBudget) return;     // would never fit
+
+    while (shard.bytes + size > shardBudget) {
+        erase(shard, prev(shard.lru.end()));
+    }
+
+    shard.lru.push_front(move(e));
+    shard.index[key] = shard.lru.begin();
+    shard.bytes += size;
+}
+
+
+void RouteCache::clear() {
+    for (auto &shard : shards) {
+        lock_guard<mutex> lock(shard->lock);
+        shard->lru.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
+
+
+void RouteCache::process(Route &route, ostream &outFile) {
+    TRACE_SCOPE("query", "query");
+
+    // no update of the map can happen during the query
+    shared_lock<shared_mutex> lock(liveMap(route.getMap()).getLock());
+
+    // the same query has another result in each output format
+    string key = route.queryKey();
+    if (getOutputFormat() != OutputFormat::Text) key += string("|") + outputFormatName();
+    unsigned long version = route.getMap()->getVersion();
+    string result, outcome;
+
+    // searches of this query add their counts to these stats
+    unique_ptr<SearchStats> stats(statsEnabled() ? new SearchStats() : nullptr);
+    StatsScope scope(stats.get());
+    auto start = chrono::steady_clock::now();
+
+    bool cached = lookup(key, version, result, outcome);
+    if (!cached) {
+        ostringstream out;
+        route.processRoute(out);
+        result = out.str();
+        outcome = route.outcome();
+
+        insert(key, version, result, outcome);
+    }
+
+    outFile << result;
+
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    queryMetrics().record(key.substr(0, key.find('|')), outcome, cached, micros);
+
+    if (stats) {
+        scope.flush();
+        stats->cached = cached;
+        stats->totalMs = micros / 1000;
+        reportStats(key, *stats, result, outFile);
+    }
+}
+
+
+size_t RouteCache::getHits() const {
+    return hits;
+}
+
+
+size_t RouteCache::getMisses() const {
+    return misses;
+}
+
+
+size_t RouteCache::getBytes() const {
+    size_t total = 0;
+    for (auto &shard : shards) {
+        lock_guard<mutex> lock(shard->lock);
+        total += shard->bytes;
+    }
+    return total;
+}
+
+
+RouteCache &routeCache() {
+    static RouteCache cache;
+    return cache;
+}
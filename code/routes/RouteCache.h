@@ -0,0 +1,159 @@
+/** @file RouteCache.h
+ *  @brief Contains the definition of the RouteCache class.
+ *
+ *  This file defines a thread-safe cache of route results. Results are stored as the text
+ *  written by `Route::processRoute`, indexed by the canonical query key of the route, so a 
+ *  repeated query is answered without running any search.
+ */
+
+#ifndef ROUTECACHE_H
+#define ROUTECACHE_H
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+#include "Route.h"
+#include "LiveMap.h"
+#include "SearchStats.h"
+#include "QueryMetrics.h"
+
+using namespace std;
+
+
+/**
+ * @class RouteCache
+ * @brief Sharded LRU cache of route results with a byte budget.
+ *
+ * Keys are spread over independent shards by their hash, each protected by its own mutex, so
+ * concurrent queries rarely contend. Every entry remembers the version of the map it was computed 
+ * on, and is discarded as soon as that map changes. When a shard goes over its share of the byte 
+ * budget, the least recently used entries are evicted.
+ */
+class RouteCache {
+
+    public:
+        /**
+         * @brief Constructor for RouteCache.
+         * @param budget Maximum number of bytes used by the cached keys and results.
+         * @param numShards Number of independent shards.
+         */
+        RouteCache(size_t budget = 64 << 20, size_t numShards = 16);
+
+        /**
+         * @brief Processes a route, answering from the cache when possible.
+         *
+         * On a miss the route is processed normally and its output is stored. The map can't be 
+         * updated while the route is processed (see LiveMap). When stats are enabled, the work 
+         * done by the query is recorded and reported (see SearchStats). The latency of every 
+         * query is added to the QueryMetrics.
+         *
+         * @param route The route to process.
+         * @param outFile The output stream where the results will be written.
+         */
+        void process(Route &route, ostream &outFile);
+
+        /**
+         * @brief Looks up a result.
+         * @param key The canonical query key.
+         * @param version The current version of the map.
+         * @param result Set to the cached result, if found.
+         * @param outcome Set to the outcome of the cached result, if found.
+         * @return True if a valid result was found, false otherwise.
+         */
+        bool lookup(const string &key, unsigned long version, string &result, string &outcome);
+
+        /**
+         * @brief Stores a result, evicting old entries if needed.
+         * @param key The canonical query key.
+         * @param version The version of the map used to compute the result.
+         * @param result The result to store.
+         * @param outcome The outcome of the route (see Route::outcome).
+         */
+        void insert(const string &key, unsigned long version, const string &result, const string &outcome);
+
+        /**
+         * @brief Removes every entry from the cache.
+         */
+        void clear();
+
+        /**
+         * @brief Gets the number of lookups answered from the cache.
+         * @return The number of hits.
+         */
+        size_t getHits() const;
+
+        /**
+         * @brief Gets the number of lookups that had to run a search.
+         * @return The number of misses.
+         */
+        size_t getMisses() const;
+
+        /**
+         * @brief Gets the number of bytes currently used by the cache.
+         * @return The number of bytes used.
+         */
+        size_t getBytes() const;
+
+    private:
+        /**
+         * @brief A cached result.
+         */
+        struct Entry {
+            string key;             ///< Canonical query key.
+            unsigned long version;  ///< Version of the map the result was computed on.
+            string result;          ///< Output of the route.
+            string outcome;         ///< Outcome of the route.
+        };
+
+        /**
+         * @brief An independently locked part of the cache.
+         */
+        struct Shard {
+            mutex lock;                                             ///< Protects the shard.
+            list<Entry> lru;                                        ///< Entries, most recently used first.
+            unordered_map<string, list<Entry>::iterator> index;     ///< Entries by key.
+            size_t bytes = 0;                                       ///< Bytes used by the shard.
+        };
+
+        vector<unique_ptr<Shard>> shards;   ///< The shards of the cache.
+        size_t shardBudget;                 ///< Byte budget of each shard.
+        atomic<size_t> hits{0};             ///< Number of hits.
+        atomic<size_t> misses{0};           ///< Number of misses.
+
+        /**
+         * @brief Gets the shard responsible for a key.
+         * @param key The canonical query key.
+         * @return The shard of the key.
+         */
+        Shard &shardFor(const string &key);
+
+        /**
+         * @brief Computes the number of bytes accounted for an entry.
+         * @param e The entry.
+         * @return The size of the entry in bytes.
+         */
+        static size_t entrySize(const Entry &e);
+
+        /**
+         * @brief Removes an entry from a shard. The shard must be locked.
+         * @param shard The shard.
+         * @param it The entry to remove.
+         */
+        static void erase(Shard &shard, list<Entry>::iterator it);
+};
+
+
+/**
+ * @brief Gets the cache shared by all route queries of the program.
+ * @return The global route cache.
+ */
+RouteCache &routeCache();
+
+
+#endif
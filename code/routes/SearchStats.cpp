@@ -0,0 +1,159 @@
+#include "SearchStats.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+
+static mutex outputLock;        // protects the settings and the sidecar file
+static atomic<bool> enabled{false};
+static bool writeInline = false;
+static ofstream sidecar;
+
+
+void SearchStats::addSearch(unsigned long settledCount, unsigned long relaxedCount, unsigned long inserts, unsigned long decreases) {
+    settled += settledCount;
+    relaxed += relaxedCount;
+    heapInserts += inserts;
+    decreaseKeys += decreases;
+}
+
+
+void SearchStats::addPhase(const string &name, double ms) {
+    lock_guard<mutex> guard(phaseLock);
+    for (auto &phase : phases) {
+        if (phase.first == name) {
+            phase.second += ms;
+            return;
+        }
+    }
+    phases.emplace_back(name, ms);
+}
+
+
+void SearchStats::addAllocations(unsigned long count, long long bytes, long long peak) {
+    allocations += count;
+    allocatedBytes += bytes;
+    long long current = peakBytes;
+    while (peak > current && !peakBytes.compare_exchange_weak(current, peak)) {}
+}
+
+
+/**
+ * @brief Writes a string as a JSON string literal.
+ */
+static void writeJsonString(ostream &out, const string &s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if ((unsigned char) c < 0x20) out << "\\u" << hex << setw(4) << setfill('0') << (int) c << dec << setfill(' ');
+        else out << c;
+    }
+    out << '"';
+}
+
+
+string SearchStats::toJson(const string &query) {
+    ostringstream out;
+    out << fixed << setprecision(3);
+
+    out << "{\"query\":";
+    writeJsonString(out, query);
+    out << ",\"cached\":" << (cached ? "true" : "false")
+        << ",\"totalMs\":" << totalMs
+        << ",\"settled\":" << settled
+        << ",\"relaxed\":" << relaxed
+        << ",\"heapInserts\":" << heapInserts
+        << ",\"decreaseKeys\":" << decreaseKeys
+        << ",\"graphCopies\":" << graphCopies
+        << ",\"copyGraphMs\":" << copyNanos / 1e6
+        << ",\"copyGraphBytes\":" << copyBytes;
+
+    if (allocationCountingEnabled()) {
+        out << ",\"allocations\":" << allocations
+            << ",\"allocatedBytes\":" << allocatedBytes
+            << ",\"peakBytes\":" << peakBytes;
+    }
+
+    out << ",\"phases\":{";
+
+    lock_guard<mutex> guard(phaseLock);
+    for (size_t i = 0; i < phases.size(); i++) {
+        writeJsonString(out, phases[i].first);
+        out << ":" << phases[i].second;
+        if (i < phases.size() - 1) out << ",";
+    }
+    out << "}}";
+    return out.str();
+}
+
+
+SearchStats *&activeStats() {
+    thread_local SearchStats *stats = nullptr;
+    return stats;
+}
+
+
+StatsScope::StatsScope(SearchStats *stats) : stats(stats), previous(activeStats()) {
+    activeStats() = stats;
+
+    // the peak of the thread is measured from here
+    AllocationCounters &counters = threadAllocations();
+    counters.peakBytes = counters.liveBytes;
+    mark = counters;
+    startLive = counters.liveBytes;
+}
+
+
+StatsScope::~StatsScope() {
+    flush();
+    activeStats() = previous;
+}
+
+
+void StatsScope::flush() {
+    if (!stats || !allocationCountingEnabled()) return;
+
+    const AllocationCounters &counters = threadAllocations();
+    stats->addAllocations(counters.allocations - mark.allocations, counters.allocatedBytes - mark.allocatedBytes, counters.peakBytes - startLive);
+    mark = counters;
+}
+
+
+bool setStatsOutput(const string &target) {
+    lock_guard<mutex> guard(outputLock);
+
+    if (sidecar.is_open()) sidecar.close();
+    writeInline = (target == "inline");
+
+    if (!target.empty() && !writeInline) {
+        sidecar.open(target, ios::app);
+        if (!sidecar) {
+            cerr << "Couldn't open the stats file " << target << "\n";
+            enabled = false;
+            return false;
+        }
+    }
+
+    enabled = !target.empty();
+    return true;
+}
+
+
+bool statsEnabled() {
+    return enabled;
+}
+
+
+void reportStats(const string &query, SearchStats &stats, const string &result, ostream &outFile) {
+    string json = stats.toJson(query);
+
+    lock_guard<mutex> guard(outputLock);
+    if (writeInline) {
+        if (!result.empty() && result.back() != '\n') outFile << '\n';
+        outFile << "Stats:" << json << '\n';
+    }
+    else if (sidecar.is_open()) sidecar << json << '\n' << flush;
+}
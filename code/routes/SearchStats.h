@@ -0,0 +1,202 @@
+/** @file SearchStats.h
+ *  @brief Contains the counters recorded while a route is computed.
+ *
+ *  This file defines the SearchStats structure, which collects how much work the searches of a
+ *  query did (vertices settled, edges relaxed, heap operations, copies of the map), how much memory
+ *  it allocated and how long each phase of the query took. Searches add their counts to the stats of the query running on
+ *  their thread, if any, so nothing is recorded unless stats were requested.
+ */
+
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <utility>
+
+#include "../data_structures/Graph.h"
+#include "../processors/memory.h"
+
+using namespace std;
+
+
+/**
+ * @brief Work done by the searches of one query, and the time taken by its phases.
+ *
+ * The counters may be updated from several threads (e.g. the workers of a DistanceMatrix).
+ */
+struct SearchStats {
+    atomic<unsigned long> settled{0};       ///< Vertices removed from the queue.
+    atomic<unsigned long> relaxed{0};       ///< Edges relaxed (scanned from a settled vertex).
+    atomic<unsigned long> heapInserts{0};   ///< Vertices inserted in the queue.
+    atomic<unsigned long> decreaseKeys{0};  ///< Keys decreased in the queue.
+    atomic<unsigned long> graphCopies{0};   ///< Copies of the map made with `copyGraph`.
+    atomic<long long> copyNanos{0};         ///< Time spent copying the map.
+    atomic<unsigned long> copyBytes{0};     ///< Bytes used by the copies of the map.
+    atomic<unsigned long> allocations{0};   ///< Blocks allocated, in the allocation-counting mode.
+    atomic<long long> allocatedBytes{0};    ///< Bytes allocated, in the allocation-counting mode.
+    atomic<long long> peakBytes{0};         ///< Highest growth of the heap of any thread of the query, in the allocation-counting mode.
+
+    mutex phaseLock;                        ///< Protects `phases`.
+    vector<pair<string, double>> phases;    ///< Wall time of each phase in milliseconds, in order.
+
+    bool cached = false;                    ///< True if the result came from the RouteCache.
+    double totalMs = 0;                     ///< Wall time of the whole query in milliseconds.
+
+    /**
+     * @brief Adds the counts of one search.
+     * @param settledCount Vertices settled by the search.
+     * @param relaxedCount Edges relaxed by the search.
+     * @param inserts Vertices inserted in the queue.
+     * @param decreases Keys decreased in the queue.
+     */
+    void addSearch(unsigned long settledCount, unsigned long relaxedCount, unsigned long inserts, unsigned long decreases);
+
+    /**
+     * @brief Adds time to a phase, creating it if it's new.
+     * @param name The name of the phase.
+     * @param ms The time in milliseconds.
+     */
+    void addPhase(const string &name, double ms);
+
+    /**
+     * @brief Adds allocations made by one thread of the query.
+     * @param count Blocks allocated.
+     * @param bytes Bytes allocated.
+     * @param peak Highest growth of the heap of the thread.
+     */
+    void addAllocations(unsigned long count, long long bytes, long long peak);
+
+    /**
+     * @brief Formats the stats as a single JSON object.
+     * @param query The key of the query (see Route::queryKey).
+     * @return The JSON object, without a trailing newline.
+     */
+    string toJson(const string &query);
+};
+
+
+/**
+ * @brief Gets the stats of the query running on the current thread.
+ * @return A reference to the pointer to the stats, which is nullptr if they aren't being recorded.
+ */
+SearchStats *&activeStats();
+
+
+/**
+ * @class StatsScope
+ * @brief Makes some stats the active ones of the current thread while it's alive.
+ *
+ * In the allocation-counting mode, the allocations made by the thread during the scope are 
+ * added to the stats as well (see memory.h).
+ */
+class StatsScope {
+    public:
+        /**
+         * @brief Activates the stats on the current thread.
+         * @param stats The stats (nullptr records nothing).
+         */
+        explicit StatsScope(SearchStats *stats);
+
+        /**
+         * @brief Adds the pending allocations and restores the stats that were active before.
+         */
+        ~StatsScope();
+
+        /**
+         * @brief Adds the allocations made by the thread so far to the stats.
+         */
+        void flush();
+
+        StatsScope(const StatsScope &) = delete;
+        StatsScope &operator=(const StatsScope &) = delete;
+
+    private:
+        SearchStats *stats;         ///< Stats activated by this scope
+        SearchStats *previous;      ///< Stats active before this scope
+        AllocationCounters mark;    ///< Counters of the thread when last flushed
+        long long startLive;        ///< Live bytes of the thread when the scope started
+};
+
+
+/**
+ * @class PhaseTimer
+ * @brief Adds the wall time of its lifetime to a phase of the active stats, if any.
+ */
+class PhaseTimer {
+    public:
+        /**
+         * @brief Starts timing a phase.
+         * @param name The name of the phase.
+         */
+        explicit PhaseTimer(const char *name) : name(name), stats(activeStats()), start(chrono::steady_clock::now()) {}
+
+        /**
+         * @brief Stops timing and records the phase.
+         */
+        ~PhaseTimer() {
+            if (stats) stats->addPhase(name, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+
+        PhaseTimer(const PhaseTimer &) = delete;
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    private:
+        const char *name;                       ///< Name of the phase
+        SearchStats *stats;                     ///< Stats where the phase is recorded
+        chrono::steady_clock::time_point start; ///< Start of the phase
+};
+
+
+/**
+ * @brief Copies a graph with `copyGraph`, recording the copy and its size in the active stats.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g Pointer to the graph.
+ * @return A pointer to the copy.
+ */
+template <class T>
+Graph<T>* timedCopyGraph(Graph<T>* g) {
+    SearchStats *stats = activeStats();
+    if (!stats) return copyGraph(g);
+
+    auto start = chrono::steady_clock::now();
+    Graph<T>* copy = copyGraph(g);
+    stats->graphCopies++;
+    stats->copyNanos += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    stats->copyBytes += copy->getMemoryUsage();
+    return copy;
+}
+
+
+/**
+ * @brief Chooses where the stats of every query are written.
+ *
+ * @param target "" to record nothing, "inline" to add a 'Stats:' line after the output of each 
+ * query, or the name of a file where one JSON line per query is appended.
+ * @return True if the output was set, false if the file couldn't be opened.
+ */
+bool setStatsOutput(const string &target);
+
+/**
+ * @brief Checks whether stats are being recorded.
+ * @return True if a stats output was set.
+ */
+bool statsEnabled();
+
+/**
+ * @brief Writes the stats of a query to the chosen output.
+ *
+ * @param query The key of the query.
+ * @param stats The stats of the query.
+ * @param result The text written by the query.
+ * @param outFile The output of the query, used by the inline mode.
+ */
+void reportStats(const string &query, SearchStats &stats, const string &result, ostream &outFile);
+
+
+#endif
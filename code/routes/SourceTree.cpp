@@ -0,0 +1,214 @@
+#include "SourceTree.h"
+
+using namespace std;
+
+
+SourceTree::SourceTree(shared_ptr<const CompactGraph<Location>> graph, int sourceId, bool mode, 
+                       shared_ptr<const SearchMask> mask, shared_ptr<const vector<int>> order)
+    : graph(graph), mask(mask), order(order), mode(mode), labels(graph->getNumVertex()) {
+
+    // an avoided source isn't in the pruned copy searched by `dijkstra`
+    int s = graph->findIndex(sourceId);
+    if (s == -1 || (mask && !mask->blockedVertex.empty() && mask->blockedVertex[s])) return;
+
+    labels[s].dist = 0;
+    pq.insert(&labels[s]);
+}
+
+
+unsigned long SourceTree::relaxEdges(int v) {
+    const CompactGraph<Location> &g = *graph;
+    const vector<double> &weights = g.getWeights(mode);
+    unsigned long relaxed = 0;
+
+    for (int i = g.getFirstEdge(v); i < g.getFirstEdge(v + 1); i++) {
+        int e = order ? (*order)[i] : i;
+        int w = g.getTarget(e);
+        if (mask && !mask->blockedEdge.empty() && mask->blockedEdge[e]) continue;
+        if (mask && !mask->blockedVertex.empty() && mask->blockedVertex[w]) continue;
+        if (labels[w].settled) continue;
+
+        relaxed++;
+        double dist = addWeight(labels[v].dist, (Weight) weights[e]);
+        if (dist < labels[w].dist) {
+            double oldDist = labels[w].dist;
+            labels[w].dist = dist;
+            labels[w].pred = v;
+            if (oldDist == INF) pq.insert(&labels[w]);
+            else pq.decreaseKey(&labels[w]);
+        }
+    }
+    return relaxed;
+}
+
+
+void SourceTree::grow(int target) {
+    TRACE_SCOPE("SourceTree::grow", "search");
+    unsigned long settledBefore = settled, relaxed = 0;
+    unsigned long insertsBefore = pq.getInserts(), decreasesBefore = pq.getDecreaseKeys();
+
+    // `dijkstra` stops right after settling its target, before relaxing its edges
+    while (!labels[target].settled) {
+        if (pending != -1) relaxed += relaxEdges(pending);
+        pending = -1;
+        if (pq.empty()) break;
+
+        Label *label = pq.extractMin();
+        label->settled = true;
+        settled++;
+        radius = label->dist;
+        pending = label - labels.data();
+    }
+
+    if (SearchStats *stats = activeStats()) {
+        stats->addSearch(settled - settledBefore, relaxed, pq.getInserts() - insertsBefore, pq.getDecreaseKeys() - decreasesBefore);
+    }
+}
+
+
+vector<int> SourceTree::getPath(int destId, double &dist) {
+    vector<int> res;
+    dist = INF;
+
+    int t = graph->findIndex(destId);
+    if (t == -1) return res;
+
+    lock_guard<mutex> guard(lock);
+    grow(t);
+    if (!labels[t].settled) return res;
+
+    dist = labels[t].dist;
+    for (int v = t; v != -1; v = labels[v].pred) {
+        res.push_back(graph->getId(v));
+    }
+    reverse(res.begin(), res.end());
+    return res;
+}
+
+
+bool SourceTree::isComplete() {
+    lock_guard<mutex> guard(lock);
+    return pending == -1 && pq.empty();
+}
+
+
+unsigned long SourceTree::getSettled() {
+    lock_guard<mutex> guard(lock);
+    return settled;
+}
+
+
+bool SourceTree::blocked(int e) const {
+    if (!mask) return false;
+    if (!mask->blockedEdge.empty() && mask->blockedEdge[e]) return true;
+    return !mask->blockedVertex.empty() && mask->blockedVertex[graph->getTarget(e)];
+}
+
+
+void SourceTree::improve(int w, double dist, int pred) {
+    if (dist >= labels[w].dist) return;
+    if (labels[w].settled) {
+        labels[w].settled = false;
+        settled--;
+    }
+
+    labels[w].dist = dist;
+    labels[w].pred = pred;
+    if (labels[w].queueIndex) pq.decreaseKey(&labels[w]);
+    else pq.insert(&labels[w]);
+}
+
+
+bool SourceTree::repair(const CompactGraph<Location> &g, const vector<WeightChange> &changes) {
+    if (&g != graph.get()) return false;
+
+    TRACE_SCOPE("SourceTree::repair", "search");
+    lock_guard<mutex> guard(lock);
+    const vector<double> &weights = g.getWeights(mode);
+    int n = g.getNumVertex();
+
+    // the settled vertex waiting for its edges gets them relaxed with the new weights; if its own
+    // label is wrong, the labels it gives are fixed below like those of its subtree
+    if (pending != -1) relaxEdges(pending);
+    pending = -1;
+
+    // 1 below a tree edge that got slower, 2 not; each labeled vertex takes the state of its predecessors
+    vector<char> state(n, 0);
+    bool slower = false;
+    for (const WeightChange &c : changes) {
+        int y = g.getTarget(c.edge);
+        if (c.mode == mode && weights[c.edge] > c.before && labels[y].pred == c.from) {
+            state[y] = 1;
+            slower = true;
+        }
+    }
+
+    if (slower) {
+        vector<int> chain;
+        for (int v = 0; v < n; v++) {
+            if (state[v] || labels[v].dist == INF) continue;
+            int u = v;
+            for (; u != -1 && state[u] == 0; u = labels[u].pred) chain.push_back(u);
+            for (int x : chain) state[x] = u == -1 ? 2 : state[u];
+            chain.clear();
+        }
+
+        // detach the subtrees
+        vector<int> detached;
+        for (int v = 0; v < n; v++) {
+            if (state[v] != 1) continue;
+            if (labels[v].queueIndex) pq.remove(&labels[v]);
+            if (labels[v].settled) settled--;
+            labels[v] = Label();
+            detached.push_back(v);
+        }
+
+        // reattach each vertex through its best edge from the vertices still settled (the map is bidirectional)
+        for (int v : detached) {
+            for (int i = g.getFirstEdge(v); i < g.getFirstEdge(v + 1); i++) {
+                int u = g.getTarget(i);
+                if (!labels[u].settled) continue;
+                for (int e = g.getFirstEdge(u); e < g.getFirstEdge(u + 1); e++) {
+                    if (g.getTarget(e) == v && !blocked(e)) improve(v, addWeight(labels[u].dist, (Weight) weights[e]), u);
+                }
+            }
+        }
+    }
+
+    // relax the edges that got faster; the edges of the vertices not settled yet are relaxed when they are
+    for (const WeightChange &c : changes) {
+        if (c.mode != mode || weights[c.edge] >= c.before || !labels[c.from].settled || blocked(c.edge)) continue;
+        improve(g.getTarget(c.edge), addWeight(labels[c.from].dist, (Weight) weights[c.edge]), c.from);
+    }
+
+    // settle again what the search had settled, improving the settled vertices that got closer
+    while (!pq.empty() && pq.findMin()->dist < radius) {
+        Label *label = pq.extractMin();
+        label->settled = true;
+        settled++;
+
+        int v = label - labels.data();
+        for (int e = g.getFirstEdge(v); e < g.getFirstEdge(v + 1); e++) {
+            if (!blocked(e)) improve(g.getTarget(e), addWeight(label->dist, (Weight) weights[e]), v);
+        }
+    }
+    return true;
+}
+
+
+size_t SourceTree::getMemoryUsage() const {
+    return sizeof(SourceTree) + labels.capacity() * sizeof(Label) + (labels.size() + 1) * sizeof(Label *);
+}
+
+
+vector<int> copyEdgeOrder(const CompactGraph<Location> &g) {
+    vector<int> order(g.getNumEdges());
+    iota(order.begin(), order.end(), 0);
+
+    for (int v = 0; v < g.getNumVertex(); v++) {
+        auto position = [&](int e) { return min(g.getTarget(e), v); };
+        stable_sort(order.begin() + g.getFirstEdge(v), order.begin() + g.getFirstEdge(v + 1),
+                    [&](int a, int b) { return position(a) < position(b); });
+    }
+    return order;
+}
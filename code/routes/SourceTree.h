@@ -0,0 +1,189 @@
+/** @file SourceTree.h
+ *  @brief Contains the definition of the SourceTree class.
+ *
+ *  This file defines a shortest path tree from one source that is grown only as far as the queries
+ *  asked of it need, and kept between queries, so that later queries from the same source with the
+ *  same metric and restrictions are answered by walking predecessors instead of searching again.
+ *  Live changes of the segment times repair the trees in place instead of dropping them.
+ */
+
+#ifndef SOURCETREE_H
+#define SOURCETREE_H
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include "SearchStats.h"
+#include "sweep.h"
+#include "metric.h"
+#include "../data_structures/Location.h"
+#include "../data_structures/CompactGraph.h"
+#include "../data_structures/MutablePriorityQueue.h"
+
+using namespace std;
+
+
+/**
+ * @brief A change of the weight of one edge of a snapshot, as patched in place by a live update.
+ */
+struct WeightChange {
+    int from;           ///< Index of the vertex the edge leaves.
+    int edge;           ///< Position of the edge in the snapshot.
+    bool mode;          ///< True if the driving weight changed, false if the walking one.
+    double before;      ///< The weight before the change.
+};
+
+
+/**
+ * @class SourceTree
+ * @brief A resumable Dijkstra search from one source over a snapshot of the map.
+ *
+ * The search is paused as soon as the vertex asked for is settled, and resumed from its queue the
+ * next time a vertex that isn't settled yet is asked for. It runs the same operations on a
+ * MutablePriorityQueue, in the same order, as `dijkstra` on the map (the snapshot keeps the order
+ * of the edges, and the restrictions skip the edges that a pruned copy wouldn't have), so ties
+ * between paths of the same time are broken the same way and the paths are the same.
+ *
+ * Restricted queries search a pruned copy of the map (see RestrictionSet::lease), whose edges
+ * `copyGraph` leaves in another order, so a tree with restrictions must be given that order
+ * (see `copyEdgeOrder`).
+ *
+ * Changes of the weights of the snapshot are repaired in place (see `repair`). The distances stay
+ * exact, but a path of the same time as another may then be chosen instead of the one `dijkstra`
+ * would choose.
+ *
+ * Safe to use from several queries at once: each call holds the lock of the tree.
+ */
+class SourceTree {
+
+    public:
+        /**
+         * @brief Starts the tree of a source, without settling anything yet.
+         * @param graph The snapshot (kept alive by the tree).
+         * @param sourceId The ID of the source location.
+         * @param mode The mode of transportation (true for driving, false for walking).
+         * @param mask Vertices and edges to avoid, if any (kept alive by the tree).
+         * @param order Order of the edges of each vertex (see `copyEdgeOrder`), nullptr for the order of the map.
+         */
+        SourceTree(shared_ptr<const CompactGraph<Location>> graph, int sourceId, bool mode, 
+                   shared_ptr<const SearchMask> mask = nullptr, shared_ptr<const vector<int>> order = nullptr);
+
+        SourceTree(const SourceTree &) = delete;
+        SourceTree &operator=(const SourceTree &) = delete;
+
+        /**
+         * @brief Gets the shortest path from the source to a location, growing the tree until it's settled.
+         * @param destId The ID of the destination location.
+         * @param dist Set to the time of the path, or INF if there is none.
+         * @return The location IDs of the path, or an empty vector if there is none.
+         */
+        vector<int> getPath(int destId, double &dist);
+
+        /**
+         * @brief Checks whether the search reached every vertex it can.
+         * @return True if the queue is exhausted.
+         */
+        bool isComplete();
+
+        /**
+         * @brief Gets the number of vertices settled so far.
+         * @return The number of settled vertices.
+         */
+        unsigned long getSettled();
+
+        /**
+         * @brief Repairs the tree after weights of its snapshot were changed in place.
+         *
+         * The subtree below each tree edge that got slower is detached and reattached through the
+         * best edge into it from the rest of the tree, and each edge that got faster is relaxed. The
+         * improvements then spread, Dijkstra-style, through the vertices settled so far, so that
+         * they are exact again and the search can be resumed as if the new weights were always
+         * there. Vertices beyond the old search radius are left to the next `getPath`.
+         *
+         * @param g The snapshot whose weights changed.
+         * @param changes The changed edges, with their old weights.
+         * @return True if the tree was repaired, false if it's on another snapshot and must be dropped.
+         */
+        bool repair(const CompactGraph<Location> &g, const vector<WeightChange> &changes);
+
+        /**
+         * @brief Computes the number of bytes used by the tree, without the snapshot and the mask.
+         *
+         * Counts the queue at its largest possible size, so it doesn't change as the tree grows.
+         *
+         * @return The number of bytes used.
+         */
+        size_t getMemoryUsage() const;
+
+    private:
+        /**
+         * @brief Search label of a vertex, as stored in the vertices by `dijkstra`.
+         */
+        struct Label {
+            double dist = INF;      ///< Distance from the source (INF if not reached).
+            int pred = -1;          ///< Index of the previous vertex on the path (-1 if none).
+            bool settled = false;   ///< True once removed from the queue.
+            int queueIndex = 0;     ///< Required by MutablePriorityQueue.
+
+            bool operator<(Label &other) const { return dist < other.dist; }
+        };
+
+        shared_ptr<const CompactGraph<Location>> graph;     ///< Snapshot the tree is computed on
+        shared_ptr<const SearchMask> mask;                  ///< Vertices and edges to avoid, if any
+        shared_ptr<const vector<int>> order;                ///< Order of the edges of each vertex, if not that of the map
+        bool mode;                                          ///< True for driving, false for walking
+
+        mutex lock;                                         ///< Protects the labels and the queue
+        vector<Label> labels;                               ///< Label of each vertex of the snapshot
+        MutablePriorityQueue<Label> pq;                     ///< Vertices reached but not settled
+        int pending = -1;                                   ///< Settled vertex whose edges aren't relaxed yet (-1 if none)
+        unsigned long settled = 0;                          ///< Number of vertices settled so far
+        double radius = 0;                                  ///< Distance of the last vertex settled by `grow`
+
+        /**
+         * @brief Resumes the search until a vertex is settled or the queue is exhausted.
+         * @param target Index of the vertex.
+         */
+        void grow(int target);
+
+        /**
+         * @brief Relaxes the outgoing edges of a settled vertex.
+         * @param v Index of the vertex.
+         * @return The number of edges relaxed.
+         */
+        unsigned long relaxEdges(int v);
+
+        /**
+         * @brief Checks whether the restrictions skip an edge.
+         * @param e Position of the edge.
+         * @return True if the edge or its target is avoided.
+         */
+        bool blocked(int e) const;
+
+        /**
+         * @brief Lowers the label of a vertex, settled or not, queueing it again. Used by `repair`.
+         * @param w Index of the vertex.
+         * @param dist The new distance (ignored if not lower than the current one).
+         * @param pred Index of the new previous vertex.
+         */
+        void improve(int w, double dist, int pred);
+};
+
+
+/**
+ * @brief Computes the order of the edges of each vertex in a copy of the map made by `copyGraph`.
+ *
+ * The copy adds both directions of every edge of each vertex, in the order of the vertices, so a
+ * vertex first gets its edges to the vertices before it, in their order, and then the rest of its
+ * own edges, in their order (the map is bidirectional, so the duplicates never improve a label).
+ *
+ * @param g The snapshot of the map.
+ * @return The positions of the edges of the snapshot, reordered within the range of each vertex.
+ */
+vector<int> copyEdgeOrder(const CompactGraph<Location> &g);
+
+
+#endif
@@ -0,0 +1,309 @@
+/** @file deltastep.h
+ *  @brief Contains a parallel one-to-all shortest path search over a CompactGraph.
+ *
+ *  Delta-stepping groups the vertices in buckets of distances of width delta. All vertices of
+ *  the lowest non-empty bucket are scanned at once, split among several threads, until the bucket
+ *  stays empty; then the next bucket is taken. With a single thread `sweepFrom` is faster, so the
+ *  one-to-all searches only switch to delta-stepping on maps large enough to pay for the threads
+ *  (see `searchFrom`).
+ */
+
+#ifndef DELTASTEP_H
+#define DELTASTEP_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+#include "../data_structures/CompactGraph.h"
+#include "SearchStats.h"
+#include "sweep.h"
+
+using namespace std;
+
+
+const int DELTA_STEP_MIN_VERTICES = 200000;    ///< Smallest map on which `searchFrom` uses delta-stepping.
+
+
+/**
+ * @brief Parameters of a delta-stepping search.
+ */
+struct DeltaStepOptions {
+    double delta = 0;       ///< Width of the buckets (0 uses `defaultDelta`).
+    unsigned threads = 0;   ///< Number of threads (0 uses the hardware concurrency).
+};
+
+
+/**
+ * @brief Barrier that makes a fixed number of threads wait for each other, as many times as needed.
+ */
+class PhaseBarrier {
+public:
+    /**
+     * @brief Builds a barrier.
+     * @param count The number of threads that must reach it.
+     */
+    explicit PhaseBarrier(unsigned count) : count(count) {}
+
+    /**
+     * @brief Waits until every thread has reached the barrier.
+     */
+    void wait() {
+        unique_lock<mutex> guard(lock);
+        unsigned long phase = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            released.notify_all();
+        } else {
+            released.wait(guard, [&]() { return generation != phase; });
+        }
+    }
+
+private:
+    mutex lock;
+    condition_variable released;
+    unsigned count;
+    unsigned waiting = 0;
+    unsigned long generation = 0;
+};
+
+
+/**
+ * @brief Computes the default width of the buckets: the average weight of the usable edges.
+ *
+ * Impassable edges (INF) are left out, or a few of them would put every vertex in the first bucket.
+ *
+ * @param weights The weights of the edges.
+ * @return The average finite weight, at least 1 (1 if no edge is usable).
+ */
+inline double defaultDelta(const vector<double> &weights) {
+    double total = 0;
+    size_t count = 0;
+    for (double w : weights) {
+        if (w >= INF) continue;
+        total += w;
+        count++;
+    }
+    return count == 0 ? 1 : max(1.0, total / count);
+}
+
+
+/**
+ * @brief Runs a delta-stepping search from a set of sources with initial distances.
+ *
+ * Computes the same distances as `sweepFrom`. The predecessor of each vertex is the incoming
+ * neighbour on a shortest path that `sweepFrom` would have settled first (the smallest distance,
+ * then the smallest index), so with positive weights the predecessors are the same too; only the
+ * order of `labels.reached` differs. When targets are given, the search stops once the buckets
+ * pass every target, and only the labels of the targets and closer vertices are final.
+ *
+ * @tparam Metric The metric to minimize (see metric.h).
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param seeds Pairs of (vertex index, initial distance).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ * @param params Width of the buckets and number of threads.
+ */
+template <class Metric, class T>
+void deltaStep(const CompactGraph<T> &g, const vector<pair<int, double>> &seeds, SearchLabels &labels,
+               const SweepOptions &options = {}, const DeltaStepOptions &params = {}) {
+    TRACE_SCOPE("deltaStep", "search");
+    int n = g.getNumVertex();
+
+    const SearchMask *mask = options.mask;
+    auto blockedVertex = [&](int v) { return mask && !mask->blockedVertex.empty() && mask->blockedVertex[v]; };
+    auto blockedEdge = [&](int e) { return mask && !mask->blockedEdge.empty() && mask->blockedEdge[e]; };
+
+    const int *edgeTargets = g.getTargets().data();
+    const vector<double> &weights = Metric::weights(g);
+
+    double delta = params.delta > 0 ? params.delta : defaultDelta(weights);
+    auto bucketOf = [&](double d) { return (size_t) (d / delta); };
+
+    unsigned threads = params.threads ? params.threads : max(1u, thread::hardware_concurrency());
+
+    vector<atomic<double>> dist(n);
+    for (auto &d : dist) d.store(INF, memory_order_relaxed);
+    vector<double> seeded(n, INF);
+    vector<long> queued(n, -1);      // bucket in which each vertex waits to be scanned (-1 if none)
+    vector<vector<int>> buckets;
+    vector<int> reached;
+
+    auto enqueue = [&](int v) {
+        size_t b = bucketOf(dist[v].load(memory_order_relaxed));
+        if (queued[v] == (long) b) return;
+        queued[v] = b;
+        if (buckets.size() <= b) buckets.resize(b + 1);
+        buckets[b].push_back(v);
+    };
+
+    for (auto &seed : seeds) {
+        int v = seed.first;
+        if (v < 0 || v >= n || blockedVertex(v) || seed.second > options.limit) continue;
+        if (seed.second < seeded[v]) {
+            if (seeded[v] == INF) reached.push_back(v);
+            seeded[v] = seed.second;
+            dist[v].store(seed.second, memory_order_relaxed);
+            enqueue(v);
+        }
+    }
+
+    vector<int> targets;
+    for (int t : options.targets) {
+        if (t >= 0) targets.push_back(t);
+    }
+
+    // state shared by the threads, only changed by thread 0 between the barriers
+    vector<int> frontier;
+    size_t current = 0;
+    bool done = false;
+    atomic<size_t> next{0};
+    vector<vector<int>> improved(threads), firstReached(threads);
+    atomic<unsigned long> relaxed{0};
+    unsigned long scans = 0, pushes = 0;
+
+    // takes the vertices of the lowest non-empty bucket as the next frontier
+    auto advance = [&]() {
+        frontier.clear();
+        next = 0;
+        for (auto &list : improved) {
+            pushes += list.size();
+            for (int w : list) enqueue(w);
+            list.clear();
+        }
+        for (auto &list : firstReached) {
+            reached.insert(reached.end(), list.begin(), list.end());
+            list.clear();
+        }
+
+        for (; current < buckets.size(); current++) {
+            // every target is closer than the buckets left
+            if (!targets.empty() && all_of(targets.begin(), targets.end(), [&](int t) { return bucketOf(dist[t].load(memory_order_relaxed)) < current; })) break;
+
+            vector<int> list;
+            list.swap(buckets[current]);
+            for (int v : list) {
+                if (queued[v] != (long) current) continue;     // moved to a lower bucket since
+                queued[v] = -1;
+                frontier.push_back(v);
+            }
+            if (!frontier.empty()) break;
+        }
+
+        scans += frontier.size();
+        done = frontier.empty();
+    };
+
+    PhaseBarrier barrier(threads);
+
+    auto worker = [&](unsigned id) {
+        unsigned long count = 0;
+        const size_t CHUNK = 64;
+
+        while (true) {
+            if (id == 0) advance();
+            barrier.wait();
+            if (done) break;
+
+            for (size_t start = next.fetch_add(CHUNK); start < frontier.size(); start = next.fetch_add(CHUNK)) {
+                for (size_t i = start; i < min(frontier.size(), start + CHUNK); i++) {
+                    int v = frontier[i];
+                    double d = dist[v].load(memory_order_relaxed);
+
+                    for (int e = g.getFirstEdge(v); e < g.getFirstEdge(v + 1); e++) {
+                        int w = edgeTargets[e];
+                        if (blockedEdge(e) || blockedVertex(w)) continue;
+
+                        count++;
+                        double nd = addWeight(d, (Weight) weights[e]);
+                        if (nd > options.limit) continue;
+
+                        double old = dist[w].load(memory_order_relaxed);
+                        while (nd < old && !dist[w].compare_exchange_weak(old, nd, memory_order_relaxed)) {}
+                        if (nd < old) {
+                            if (old == INF) firstReached[id].push_back(w);
+                            improved[id].push_back(w);
+                        }
+                    }
+                }
+            }
+            barrier.wait();
+        }
+
+        relaxed += count;
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++) workers.emplace_back(worker, t);
+    worker(0);
+    for (auto &t : workers) t.join();
+
+    labels.dist.assign(n, INF);
+    labels.pred.assign(n, -1);
+    labels.reached = reached;
+    for (int v : reached) labels.dist[v] = dist[v].load(memory_order_relaxed);
+
+    // the predecessor is the neighbour on a shortest path that a sweep would have settled first
+    for (int v : reached) {
+        double d = labels.dist[v];
+        if (d == seeded[v]) continue;
+        int pred = -1;
+        for (int i = g.getFirstIncoming(v); i < g.getFirstIncoming(v + 1); i++) {
+            int e = g.getIncoming(i);
+            int u = g.getOrigin(e);
+            if (blockedEdge(e) || blockedVertex(u)) continue;
+
+            double du = labels.dist[u];
+            if (addWeight(du, (Weight) weights[e]) != d || make_pair(du, u) >= make_pair(d, v)) continue;
+            if (pred == -1 || make_pair(du, u) < make_pair(labels.dist[pred], pred)) pred = u;
+        }
+        labels.pred[v] = pred;
+    }
+
+    if (SearchStats *stats = activeStats()) stats->addSearch(scans, relaxed, pushes, 0);
+}
+
+
+/**
+ * @brief Runs a delta-stepping search from a set of sources with initial distances (see `deltaStep<Metric>`).
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param seeds Pairs of (vertex index, initial distance).
+ * @param mode The mode of transportation (true for driving, false for walking).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ * @param params Width of the buckets and number of threads.
+ */
+template <class T>
+void deltaStep(const CompactGraph<T> &g, const vector<pair<int, double>> &seeds, bool mode, SearchLabels &labels,
+               const SweepOptions &options = {}, const DeltaStepOptions &params = {}) {
+    if (mode) deltaStep<DrivingMetric>(g, seeds, labels, options, params);
+    else deltaStep<WalkingMetric>(g, seeds, labels, options, params);
+}
+
+
+/**
+ * @brief Runs a one-to-all search from a set of sources with initial distances.
+ *
+ * Uses `deltaStep` on maps of at least DELTA_STEP_MIN_VERTICES vertices when no targets are
+ * given (a search that stops early gains little from the threads), and `sweepFrom` otherwise.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param seeds Pairs of (vertex index, initial distance).
+ * @param mode The mode of transportation (true for driving, false for walking).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ */
+template <class T>
+void searchFrom(const CompactGraph<T> &g, const vector<pair<int, double>> &seeds, bool mode, SearchLabels &labels, const SweepOptions &options = {}) {
+    if (g.getNumVertex() >= DELTA_STEP_MIN_VERTICES && options.targets.empty()) deltaStep(g, seeds, mode, labels, options);
+    else sweepFrom(g, seeds, mode, labels, options);
+}
+
+#endif
@@ -2,15 +2,19 @@
  *  @brief Contains the implementation of Dijkstra's algorithm.
  *
  *  This file implements the function `dijkstra` that calculates the shortest path 
- *  between two vertices in a graph.
+ *  between two vertices in a graph, or from one vertex until a distance, a number of
+ *  settled vertices or a set of targets is reached.
  */
 
 #ifndef DIJKSTRA_H
 #define DIJKSTRA_H
 
 
+#include <unordered_set>
 #include "../data_structures/Graph.h"
 #include "../data_structures/MutablePriorityQueue.h"
+#include "SearchStats.h"
+#include "metric.h"
 
 using namespace std;
 
@@ -18,29 +22,34 @@ using namespace std;
 /**
  * @brief Relaxes an edge if a shorter path is found.
  *
+ * @tparam Metric The metric to minimize (see metric.h).
  * @tparam T Type of the graph vertices.
  * @param edge The edge being relaxed.
- * @param mode The mode of transportation (true for driving, false for walking).
  * @return True if the edge was relaxed, false otherwise.
  */
-template <class T>
-bool relax(Edge<T> *edge, bool mode) { // d[u] + w(u,v) < d[v]
-    if (mode) {
-        if (edge->getOrig()->getDist() + edge->getDriving() < edge->getDest()->getDist()) {
-            edge->getDest()->setDist(edge->getOrig()->getDist() + edge->getDriving());
-            edge->getDest()->setPath(edge);
-            return true;
-        }
-        return false;
-    }
-
-    if (edge->getOrig()->getDist() + edge->getWalking() < edge->getDest()->getDist()) {
-        edge->getDest()->setDist(edge->getOrig()->getDist() + edge->getWalking());
+template <class Metric, class T>
+bool relax(Edge<T> *edge) { // d[u] + w(u,v) < d[v]
+    double dist = addWeight(edge->getOrig()->getDist(), Metric::weight(edge));
+    if (dist < edge->getDest()->getDist()) {
+        edge->getDest()->setDist(dist);
         edge->getDest()->setPath(edge);
         return true;
     }
     return false;
-   
+}
+
+
+/**
+ * @brief Relaxes an edge if a shorter path is found.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param edge The edge being relaxed.
+ * @param mode The mode of transportation (true for driving, false for walking).
+ * @return True if the edge was relaxed, false otherwise.
+ */
+template <class T>
+bool relax(Edge<T> *edge, bool mode) {
+    return mode ? relax<DrivingMetric>(edge) : relax<WalkingMetric>(edge);
 }
 
 
@@ -68,21 +77,42 @@ bool initDijkstra(Graph<T> * g) {
 
 
 /**
- * @brief Runs Dijkstra's shortest path algorithm from a source to a destination.
+ * @brief Conditions that end a search early.
  *
+ * The vertices are settled in order of distance, and the search stops before settling a vertex
+ * farther than `maxDist`, once `maxSettled` vertices are settled or once every target is settled,
+ * whichever comes first. Without any condition the search runs over the whole component of the origin.
+ */
+struct SearchLimits {
+    double maxDist = INF;               ///< Largest distance of a vertex that may be settled.
+    unsigned long maxSettled = 0;       ///< Largest number of vertices to settle (0 for no cap).
+    vector<int> targets;                ///< IDs of the locations after which the search may stop (none if empty).
+};
+
+
+/**
+ * @brief Runs Dijkstra's shortest path algorithm from a source until a limit is reached.
+ *
+ * Only the settled (visited) vertices have final distances and paths: a vertex left unsettled
+ * may keep a tentative distance, which is always larger than `limits.maxDist`.
+ * The work done is added to the active SearchStats, if any.
+ *
+ * @tparam Metric The metric to minimize (see metric.h).
  * @tparam T Type of the graph vertices.
  * @param g Pointer to the graph.
  * @param origin The ID of the starting vertex.
- * @param dest The ID of the destination vertex.
- * @param mode The mode of transportation (true for driving, false for walking).
+ * @param limits When to stop.
  */
-template <class T>
-void dijkstra(Graph<T> * g, const int &origin, const int &dest, bool mode) {
+template <class Metric, class T>
+void dijkstra(Graph<T> * g, const int &origin, const SearchLimits &limits) {
+    TRACE_SCOPE("dijkstra", "search");
 
     //we find ids
     Vertex<T> *s = g->findLocationId(origin);
-    Vertex<T> *d = g->findLocationId(dest);
-    if (!s || !d) return;
+    if (!s || limits.maxDist < 0) return;
+
+    unordered_set<int> targets(limits.targets.begin(), limits.targets.end());
+    size_t remaining = targets.size();
 
     s->setDist(0);
 
@@ -90,18 +120,24 @@ void dijkstra(Graph<T> * g, const int &origin, const int &dest, bool mode) {
     MutablePriorityQueue<Vertex<T>> pq;
     pq.insert(s);
 
+    unsigned long settled = 0, relaxed = 0;
+
     //process queue vertices
     while (!pq.empty()) {
         Vertex<T>* v = pq.extractMin();
+        if (v->getDist() > limits.maxDist) break;
         v->setVisited(true);
+        settled++;
 
-        if (v == d) return;
+        if (remaining && targets.count(v->getInfo().getId()) && --remaining == 0) break;
+        if (settled == limits.maxSettled) break;
 
         for (auto e : v->getAdj()) {
             Vertex<T> *w = e->getDest();
             if (!w->isVisited()) {
                 double oldDist = e->getDest()->getDist();
-                if (relax(e, mode)) {
+                relaxed++;
+                if (relax<Metric>(e)) {
                     if (oldDist == INF) pq.insert(e->getDest());
                     else pq.decreaseKey(e->getDest());
                 }
@@ -109,6 +145,60 @@ void dijkstra(Graph<T> * g, const int &origin, const int &dest, bool mode) {
         }
     }
 
+    if (SearchStats *stats = activeStats()) stats->addSearch(settled, relaxed, pq.getInserts(), pq.getDecreaseKeys());
+}
+
+
+/**
+ * @brief Runs Dijkstra's shortest path algorithm from a source to a destination.
+ *
+ * The search stops once the destination is settled (see `dijkstra` with SearchLimits).
+ *
+ * @tparam Metric The metric to minimize (see metric.h).
+ * @tparam T Type of the graph vertices.
+ * @param g Pointer to the graph.
+ * @param origin The ID of the starting vertex.
+ * @param dest The ID of the destination vertex.
+ */
+template <class Metric, class T>
+void dijkstra(Graph<T> * g, const int &origin, const int &dest) {
+    if (!g->findLocationId(dest)) return;
+
+    SearchLimits limits;
+    limits.targets = {dest};
+    dijkstra<Metric>(g, origin, limits);
+}
+
+
+/**
+ * @brief Runs Dijkstra's shortest path algorithm from a source to a destination.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g Pointer to the graph.
+ * @param origin The ID of the starting vertex.
+ * @param dest The ID of the destination vertex.
+ * @param mode The mode of transportation (true for driving, false for walking).
+ */
+template <class T>
+void dijkstra(Graph<T> * g, const int &origin, const int &dest, bool mode) {
+    if (mode) dijkstra<DrivingMetric>(g, origin, dest);
+    else dijkstra<WalkingMetric>(g, origin, dest);
+}
+
+
+/**
+ * @brief Runs Dijkstra's shortest path algorithm from a source until a limit is reached.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g Pointer to the graph.
+ * @param origin The ID of the starting vertex.
+ * @param limits When to stop (see SearchLimits).
+ * @param mode The mode of transportation (true for driving, false for walking).
+ */
+template <class T>
+void dijkstra(Graph<T> * g, const int &origin, const SearchLimits &limits, bool mode) {
+    if (mode) dijkstra<DrivingMetric>(g, origin, limits);
+    else dijkstra<WalkingMetric>(g, origin, limits);
 }
 
 
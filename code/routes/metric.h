@@ -0,0 +1,77 @@
+/** @file metric.h
+ *  @brief Contains the metrics that the searches minimize.
+ *
+ *  A metric is a policy class that tells a search which weight column of the map to read.
+ *  The searches are templates on the metric, so each metric gets its own instantiation without
+ *  a branch on the mode per edge, and a new cost column only needs a new policy. Every metric
+ *  provides:
+ *
+ *  - `name`, the name of the mode;
+ *  - `weight(edge)`, the weight of an edge of a Graph, as a Weight;
+ *  - `weights(g)`, the weight column of a CompactGraph.
+ *
+ *  Weights are whole minutes, read from the data sets as integers, and INF marks an edge that
+ *  can't be used. The searches (`dijkstra`, SourceTree, `sweepFrom`, `multiSweep` and `deltaStep`)
+ *  are templates on the metric, and add distances with `addWeight`, which saturates at INF, so an
+ *  impassable edge or an unreached vertex never produces a distance that looks reachable. The
+ *  relaxation kernels of relax.h add without saturating, but only report sums below both the
+ *  current label and the limit, so an INF weight never improves a label there either.
+ */
+
+#ifndef METRIC_H
+#define METRIC_H
+
+#include <vector>
+#include "../data_structures/Graph.h"
+#include "../data_structures/CompactGraph.h"
+
+using namespace std;
+
+
+typedef int Weight;     ///< Weight of an edge, in minutes (INF if the edge can't be used).
+
+
+/**
+ * @brief Adds the weight of an edge to a distance.
+ * @param dist The distance to the origin of the edge (INF if unreached).
+ * @param w The weight of the edge (INF if it can't be used).
+ * @return The distance to the destination through the edge, or INF if either is INF or the sum reaches INF.
+ */
+inline double addWeight(double dist, Weight w) {
+    if (dist >= INF || w >= INF) return INF;
+    double sum = dist + w;
+    return sum >= INF ? INF : sum;
+}
+
+
+/**
+ * @brief Metric of the driving times.
+ */
+struct DrivingMetric {
+    static constexpr const char *name = "driving";  ///< Name of the mode.
+    static constexpr bool mode = true;              ///< Value of the `mode` flag of the older interfaces.
+
+    template <class T>
+    static Weight weight(const Edge<T> *e) { return (Weight) e->getDriving(); }
+
+    template <class T>
+    static const vector<double> &weights(const CompactGraph<T> &g) { return g.getWeights(true); }
+};
+
+
+/**
+ * @brief Metric of the walking times.
+ */
+struct WalkingMetric {
+    static constexpr const char *name = "walking";  ///< Name of the mode.
+    static constexpr bool mode = false;             ///< Value of the `mode` flag of the older interfaces.
+
+    template <class T>
+    static Weight weight(const Edge<T> *e) { return (Weight) e->getWalking(); }
+
+    template <class T>
+    static const vector<double> &weights(const CompactGraph<T> &g) { return g.getWeights(false); }
+};
+
+
+#endif
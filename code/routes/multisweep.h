@@ -0,0 +1,238 @@
+/** @file multisweep.h
+ *  @brief Contains shortest path searches from several sources at once over a CompactGraph.
+ *
+ *  A batch of up to RELAX_LANES sources is searched together: each vertex keeps one distance
+ *  label per source (its lanes), and each scan of the outgoing edges of a vertex relaxes the
+ *  labels of every source with one call of a lane kernel (see relax.h). Filling a distance
+ *  matrix this way reads the adjacency arrays once per batch instead of once per source.
+ */
+
+#ifndef MULTISWEEP_H
+#define MULTISWEEP_H
+
+#include <queue>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "../data_structures/CompactGraph.h"
+#include "SearchStats.h"
+#include "sweep.h"
+#include "relax.h"
+
+using namespace std;
+
+
+/**
+ * @brief Labels computed by a multi-source search over a CompactGraph.
+ *
+ * As with SearchLabels, only the vertices reached by the previous search are reset.
+ * There are no predecessor labels: paths are rebuilt from the distances (see `getMultiSweepPath`).
+ */
+struct MultiSearchLabels {
+    vector<double> dist;    ///< Distance from each source to each vertex, RELAX_LANES per vertex (INF if not reached).
+    vector<int> sources;    ///< Index of the source of each lane (-1 for unused lanes).
+    vector<int> reached;    ///< Vertices whose labels were set by the last search.
+
+    /**
+     * @brief Gets the distance from the source of a lane to a vertex.
+     * @param lane The lane of the source.
+     * @param v The index of the vertex.
+     * @return The distance, or INF if not reached.
+     */
+    double getDist(int lane, int v) const { return dist[(size_t) v * RELAX_LANES + lane]; }
+};
+
+
+/**
+ * @brief Runs Dijkstra's algorithm from up to RELAX_LANES sources at once.
+ *
+ * The vertices are scanned in the order of the smallest label improved since their last scan,
+ * and scanned again if a later scan improves another of their lanes (a label-correcting search),
+ * so every lane ends with the same distances as a `sweep` from its source. When targets are
+ * given, the search stops once no pending label can improve the distance of a target from any
+ * source. Restrictions and the distance limit apply to every lane.
+ *
+ * @tparam Metric The metric to minimize (see metric.h).
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param sources Indexes of the source vertices, at most RELAX_LANES (lane `k` is `sources[k]`).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ */
+template <class Metric, class T>
+void multiSweep(const CompactGraph<T> &g, const vector<int> &sources, MultiSearchLabels &labels, const SweepOptions &options = {}) {
+    TRACE_SCOPE("multiSweep", "search");
+    int n = g.getNumVertex();
+
+    if (labels.dist.size() != (size_t) n * RELAX_LANES) {
+        labels.dist.assign((size_t) n * RELAX_LANES, INF);
+    } else {
+        for (int v : labels.reached) fill_n(labels.dist.begin() + (size_t) v * RELAX_LANES, RELAX_LANES, (double) INF);
+    }
+    labels.reached.clear();
+    labels.sources.assign(RELAX_LANES, -1);
+
+    // the kernels have no mask: a restricted edge gets an infinite weight instead
+    const vector<double> *weights = &Metric::weights(g);
+    vector<double> restricted;
+    if (const SearchMask *mask = options.mask) {
+        restricted = *weights;
+        for (int e = 0; e < g.getNumEdges(); e++) {
+            bool blocked = !mask->blockedEdge.empty() && mask->blockedEdge[e];
+            if (!mask->blockedVertex.empty()) blocked = blocked || mask->blockedVertex[g.getOrigin(e)] || mask->blockedVertex[g.getTarget(e)];
+            if (blocked) restricted[e] = INF;
+        }
+        weights = &restricted;
+    }
+    auto blockedVertex = [&](int v) { return options.mask && !options.mask->blockedVertex.empty() && options.mask->blockedVertex[v]; };
+
+    vector<int> targets;
+    for (int t : options.targets) {
+        if (t >= 0) targets.push_back(t);
+    }
+
+    vector<unsigned> dirty(n, 0);     // lanes improved since the last scan of each vertex
+    vector<char> reached(n, 0);
+
+    typedef pair<double, int> Item;
+    priority_queue<Item, vector<Item>, greater<Item>> pq;
+    unsigned long scans = 0, relaxed = 0, pushes = 0;
+
+    for (int k = 0; k < (int) sources.size() && k < RELAX_LANES; k++) {
+        int v = sources[k];
+        if (v < 0 || v >= n || blockedVertex(v) || options.limit < 0) continue;
+        labels.sources[k] = v;
+
+        if (!reached[v]) labels.reached.push_back(v);
+        reached[v] = 1;
+        labels.dist[(size_t) v * RELAX_LANES + k] = 0;
+        dirty[v] |= 1u << k;
+        pq.push({0.0, v});
+        pushes++;
+    }
+
+    // largest distance from a source to a target, recomputed now and then (it only decreases)
+    auto targetBound = [&]() {
+        double bound = 0;
+        for (int t : targets) {
+            for (int k = 0; k < RELAX_LANES; k++) {
+                if (labels.sources[k] != -1) bound = max(bound, labels.getDist(k, t));
+            }
+        }
+        return bound;
+    };
+    double bound = INF;
+
+    LaneKernel kernel = laneKernel();
+    const int *edgeTargets = g.getTargets().data();
+    vector<unsigned> lanes;
+
+    while (!pq.empty()) {
+        auto [d, v] = pq.top();
+        pq.pop();
+        if (!dirty[v]) continue;     // scanned since this entry was pushed
+
+        // every pending improvement is at least d away from its source
+        if (!targets.empty() && (scans % 64 == 0 || d >= bound)) {
+            bound = targetBound();
+            if (d >= bound && bound != INF) break;
+        }
+
+        dirty[v] = 0;
+        scans++;
+
+        int first = g.getFirstEdge(v), last = g.getFirstEdge(v + 1);
+        if ((int) lanes.size() < last - first) lanes.resize(last - first);
+        kernel(edgeTargets, weights->data(), first, last, &labels.dist[(size_t) v * RELAX_LANES], labels.dist.data(), options.limit, lanes.data());
+        relaxed += last - first;
+
+        for (int e = first; e < last; e++) {
+            unsigned improved = lanes[e - first];
+            if (!improved) continue;
+
+            int w = edgeTargets[e];
+            if (!reached[w]) labels.reached.push_back(w);
+            reached[w] = 1;
+
+            // the new entry is ordered by the smallest label just improved
+            const double *to = &labels.dist[(size_t) w * RELAX_LANES];
+            double key = INF;
+            for (unsigned bits = improved; bits; bits &= bits - 1) key = min(key, to[__builtin_ctz(bits)]);
+            dirty[w] |= improved;
+            pq.push({key, w});
+            pushes++;
+        }
+    }
+
+    if (SearchStats *stats = activeStats()) stats->addSearch(scans, relaxed, pushes, 0);
+}
+
+
+/**
+ * @brief Runs Dijkstra's algorithm from up to RELAX_LANES sources at once (see `multiSweep<Metric>`).
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param sources Indexes of the source vertices, at most RELAX_LANES (lane `k` is `sources[k]`).
+ * @param mode The mode of transportation (true for driving, false for walking).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ */
+template <class T>
+void multiSweep(const CompactGraph<T> &g, const vector<int> &sources, bool mode, MultiSearchLabels &labels, const SweepOptions &options = {}) {
+    if (mode) multiSweep<DrivingMetric>(g, sources, labels, options);
+    else multiSweep<WalkingMetric>(g, sources, labels, options);
+}
+
+
+/**
+ * @brief Retrieves the shortest path from the source of a lane to a vertex.
+ *
+ * The predecessor of each vertex is the incoming neighbour on a shortest path that a `sweep`
+ * from the same source would have settled first (the smallest distance, then the smallest index),
+ * so with positive weights the paths are the same as those of `getSweepPath`.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param labels The labels computed by `multiSweep`, with every vertex of the path settled.
+ * @param lane The lane of the source.
+ * @param target Index of the destination vertex.
+ * @param mode The mode of transportation used by the search.
+ * @param mask The restrictions used by the search, if any.
+ * @return The location IDs of the path from the source to the target, or an empty vector if unreachable.
+ */
+template <class T>
+vector<int> getMultiSweepPath(const CompactGraph<T> &g, const MultiSearchLabels &labels, int lane, int target, bool mode, const SearchMask *mask = nullptr) {
+    vector<int> res;
+    if (lane < 0 || lane >= RELAX_LANES || labels.sources[lane] == -1) return res;
+    if (target < 0 || (size_t) target * RELAX_LANES >= labels.dist.size() || labels.getDist(lane, target) == INF) return res;
+
+    const vector<double> &weights = g.getWeights(mode);
+    int source = labels.sources[lane];
+
+    for (int v = target; ; ) {
+        res.push_back(g.getId(v));
+        if (v == source) break;
+
+        double d = labels.getDist(lane, v);
+        int pred = -1;
+        for (int i = g.getFirstIncoming(v); i < g.getFirstIncoming(v + 1); i++) {
+            int e = g.getIncoming(i);
+            int u = g.getOrigin(e);
+            if (mask && !mask->blockedEdge.empty() && mask->blockedEdge[e]) continue;
+
+            double du = labels.getDist(lane, u);
+            if (addWeight(du, (Weight) weights[e]) != d || make_pair(du, u) >= make_pair(d, v)) continue;
+            if (pred == -1 || make_pair(du, u) < make_pair(labels.getDist(lane, pred), pred)) pred = u;
+        }
+
+        // labels left unsettled by a search that stopped early
+        if (pred == -1) return {};
+        v = pred;
+    }
+
+    reverse(res.begin(), res.end());
+    return res;
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "relax.h"
+
+#include <atomic>
+
+#ifdef DA_AVX2_RELAX
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+
+int relaxEdgesScalar(const int *targets, const double *weights, int first, int last, double d, const double *dist, double limit, int *improved) {
+    int count = 0;
+    for (int e = first; e < last; e++) {
+        double nd = d + weights[e];
+        if (nd < dist[targets[e]] && nd <= limit) improved[count++] = e;
+    }
+    return count;
+}
+
+
+void relaxLanesScalar(const int *targets, const double *weights, int first, int last, const double *from, double *dist, double limit, unsigned *lanes) {
+    for (int e = first; e < last; e++) {
+        double *to = dist + (size_t) targets[e] * RELAX_LANES;
+        unsigned mask = 0;
+        for (int k = 0; k < RELAX_LANES; k++) {
+            double nd = from[k] + weights[e];
+            if (nd < to[k] && nd <= limit) {
+                to[k] = nd;
+                mask |= 1u << k;
+            }
+        }
+        lanes[e - first] = mask;
+    }
+}
+
+
+#ifdef DA_AVX2_RELAX
+
+static const int AVX2_MIN_EDGES = 8;    ///< Vertices with fewer edges are relaxed by the scalar kernel.
+
+
+__attribute__((target("avx2")))
+int relaxEdgesAVX2(const int *targets, const double *weights, int first, int last, double d, const double *dist, double limit, int *improved) {
+    // gathering the distances of a few edges costs more than loading them one by one
+    if (last - first < AVX2_MIN_EDGES) return relaxEdgesScalar(targets, weights, first, last, d, dist, limit, improved);
+
+    int count = 0;
+    int e = first;
+
+    const __m256d from = _mm256_set1_pd(d);
+    const __m256d bound = _mm256_set1_pd(limit);
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+    for (; e + 4 <= last; e += 4) {
+        __m128i to = _mm_loadu_si128(reinterpret_cast<const __m128i *>(targets + e));
+        __m256d nd = _mm256_add_pd(from, _mm256_loadu_pd(weights + e));
+        // the masked form, because GCC takes the unmasked one's undefined source as uninitialised
+        __m256d old = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), dist, to, all, 8);
+
+        __m256d better = _mm256_and_pd(_mm256_cmp_pd(nd, old, _CMP_LT_OQ), _mm256_cmp_pd(nd, bound, _CMP_LE_OQ));
+        int lanes = _mm256_movemask_pd(better);
+
+        // AVX2 has no scatter, and the caller applies the improvements in order anyway
+        while (lanes) {
+            improved[count++] = e + __builtin_ctz(lanes);
+            lanes &= lanes - 1;
+        }
+    }
+
+    return count + relaxEdgesScalar(targets, weights, e, last, d, dist, limit, improved + count);
+}
+
+
+__attribute__((target("avx2")))
+void relaxLanesAVX2(const int *targets, const double *weights, int first, int last, const double *from, double *dist, double limit, unsigned *lanes) {
+    static_assert(RELAX_LANES == 8, "the AVX2 lane kernel handles two vectors of four lanes");
+
+    const __m256d low = _mm256_loadu_pd(from);
+    const __m256d high = _mm256_loadu_pd(from + 4);
+    const __m256d bound = _mm256_set1_pd(limit);
+
+    for (int e = first; e < last; e++) {
+        double *to = dist + (size_t) targets[e] * RELAX_LANES;
+        __m256d w = _mm256_set1_pd(weights[e]);
+
+        __m256d nd = _mm256_add_pd(low, w);
+        __m256d old = _mm256_loadu_pd(to);
+        __m256d better = _mm256_and_pd(_mm256_cmp_pd(nd, old, _CMP_LT_OQ), _mm256_cmp_pd(nd, bound, _CMP_LE_OQ));
+        _mm256_storeu_pd(to, _mm256_blendv_pd(old, nd, better));
+        unsigned mask = _mm256_movemask_pd(better);
+
+        nd = _mm256_add_pd(high, w);
+        old = _mm256_loadu_pd(to + 4);
+        better = _mm256_and_pd(_mm256_cmp_pd(nd, old, _CMP_LT_OQ), _mm256_cmp_pd(nd, bound, _CMP_LE_OQ));
+        _mm256_storeu_pd(to + 4, _mm256_blendv_pd(old, nd, better));
+        lanes[e - first] = mask | (unsigned) _mm256_movemask_pd(better) << 4;
+    }
+}
+
+#endif
+
+
+bool simdRelaxSupported() {
+#ifdef DA_AVX2_RELAX
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+
+static atomic<bool> simdEnabled{true};
+
+
+RelaxKernel relaxKernel() {
+#ifdef DA_AVX2_RELAX
+    if (simdEnabled && simdRelaxSupported()) return relaxEdgesAVX2;
+#endif
+    return relaxEdgesScalar;
+}
+
+
+LaneKernel laneKernel() {
+#ifdef DA_AVX2_RELAX
+    if (simdEnabled && simdRelaxSupported()) return relaxLanesAVX2;
+#endif
+    return relaxLanesScalar;
+}
+
+
+const char *relaxKernelName() {
+    return relaxKernel() == relaxEdgesScalar ? "scalar" : "avx2";
+}
+
+
+void setSimdRelax(bool enabled) {
+    simdEnabled = enabled;
+}
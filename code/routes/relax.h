@@ -0,0 +1,127 @@
+/** @file relax.h
+ *  @brief Contains the edge relaxation kernels used by the searches over a CompactGraph.
+ *
+ *  Relaxing the outgoing edges of a settled vertex of a CompactGraph reads contiguous arrays of
+ *  targets and weights, gathers the distances of the targets, adds and compares. This file
+ *  declares a scalar kernel and, on x86-64, an AVX2 kernel that handles four edges per
+ *  instruction. The AVX2 kernel is only used if the CPU supports it, which is checked at run time,
+ *  so the program runs on any x86-64 CPU without special compiler flags.
+ *
+ *  It also declares the kernels of the multi-source searches (see multisweep.h), which relax the
+ *  edges of a vertex for RELAX_LANES sources at once.
+ */
+
+#ifndef RELAX_H
+#define RELAX_H
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define DA_AVX2_RELAX 1    ///< Defined when the AVX2 kernel is compiled.
+#endif
+
+
+/**
+ * @brief Finds the outgoing edges of a settled vertex that improve the distance of their target.
+ *
+ * Edge `e` improves its target if `d + weights[e] < dist[targets[e]]` and `d + weights[e] <= limit`.
+ * The distances are read once, before any of them is updated, so the caller must check each
+ * improving edge again in order (an earlier parallel edge may already have improved the same target).
+ * Edges that don't improve their target at this point can't improve it after the others are applied.
+ *
+ * @param targets Destination of each edge.
+ * @param weights Weight of each edge.
+ * @param first Position of the first edge of the vertex.
+ * @param last Position after the last edge of the vertex.
+ * @param d Distance of the settled vertex.
+ * @param dist Current distance of each vertex.
+ * @param limit Largest distance that may be labelled.
+ * @param improved Filled with the positions of the improving edges, in order (room for `last - first`).
+ * @return The number of improving edges.
+ */
+typedef int (*RelaxKernel)(const int *targets, const double *weights, int first, int last, double d, const double *dist, double limit, int *improved);
+
+
+/**
+ * @brief Relaxation kernel that handles one edge at a time (see RelaxKernel).
+ */
+int relaxEdgesScalar(const int *targets, const double *weights, int first, int last, double d, const double *dist, double limit, int *improved);
+
+#ifdef DA_AVX2_RELAX
+/**
+ * @brief Relaxation kernel that handles four edges at a time with AVX2 (see RelaxKernel).
+ *
+ * Vertices with few edges, most of them in a road network, are handed to the scalar kernel.
+ * Must only be called if `simdRelaxSupported()`.
+ */
+int relaxEdgesAVX2(const int *targets, const double *weights, int first, int last, double d, const double *dist, double limit, int *improved);
+#endif
+
+
+const int RELAX_LANES = 8;    ///< Number of sources relaxed at once by a LaneKernel.
+
+
+/**
+ * @brief Relaxes the outgoing edges of a vertex for several sources at once.
+ *
+ * Each vertex has RELAX_LANES distance labels, one per source, stored contiguously in `dist`.
+ * For each edge `e` and lane `k`, if `from[k] + weights[e] < dist[targets[e]][k]` and it is at most
+ * `limit`, the label is lowered. The edges are applied in order.
+ *
+ * @param targets Destination of each edge.
+ * @param weights Weight of each edge (INF for an edge that must not be used).
+ * @param first Position of the first edge of the vertex.
+ * @param last Position after the last edge of the vertex.
+ * @param from Labels of the vertex (RELAX_LANES values).
+ * @param dist Labels of every vertex.
+ * @param limit Largest distance that may be labelled.
+ * @param lanes Filled with the bit mask of the lanes lowered by each edge (room for `last - first`).
+ */
+typedef void (*LaneKernel)(const int *targets, const double *weights, int first, int last, const double *from, double *dist, double limit, unsigned *lanes);
+
+
+/**
+ * @brief Lane kernel that handles one source at a time (see LaneKernel).
+ */
+void relaxLanesScalar(const int *targets, const double *weights, int first, int last, const double *from, double *dist, double limit, unsigned *lanes);
+
+#ifdef DA_AVX2_RELAX
+/**
+ * @brief Lane kernel that handles four sources per instruction with AVX2 (see LaneKernel).
+ *
+ * Must only be called if `simdRelaxSupported()`.
+ */
+void relaxLanesAVX2(const int *targets, const double *weights, int first, int last, const double *from, double *dist, double limit, unsigned *lanes);
+#endif
+
+
+/**
+ * @brief Checks whether the CPU can run the AVX2 kernel.
+ * @return True if the kernel was compiled in and the CPU supports AVX2.
+ */
+bool simdRelaxSupported();
+
+/**
+ * @brief Gets the kernel used by the searches.
+ * @return The AVX2 kernel if supported and not disabled, the scalar kernel otherwise.
+ */
+RelaxKernel relaxKernel();
+
+/**
+ * @brief Gets the lane kernel used by the multi-source searches.
+ * @return The AVX2 kernel if supported and not disabled, the scalar kernel otherwise.
+ */
+LaneKernel laneKernel();
+
+/**
+ * @brief Gets the name of the kernel used by the searches.
+ * @return "avx2" or "scalar".
+ */
+const char *relaxKernelName();
+
+/**
+ * @brief Chooses whether the searches may use the AVX2 kernels (e.g. to compare both in a benchmark).
+ * @param enabled False to always use the scalar kernel.
+ */
+void setSimdRelax(bool enabled);
+
+
+#endif
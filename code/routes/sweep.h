@@ -0,0 +1,252 @@
+/** @file sweep.h
+ *  @brief Contains one-to-all shortest path searches over a CompactGraph.
+ *
+ *  Unlike `dijkstra`, these searches keep their distance and predecessor labels in a separate
+ *  `SearchLabels` object instead of the vertices, so many of them can run in parallel on the
+ *  same snapshot of the map. Restrictions are applied through a `SearchMask` instead of removing
+ *  vertices and edges from a copy of the map.
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <queue>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "../data_structures/CompactGraph.h"
+#include "SearchStats.h"
+#include "relax.h"
+#include "metric.h"
+
+using namespace std;
+
+
+/**
+ * @brief Labels computed by a search over a CompactGraph.
+ *
+ * The labels can be reused by several searches: only the vertices reached by the previous
+ * search are reset, so a search that stops early doesn't pay for the size of the map.
+ */
+struct SearchLabels {
+    vector<double> dist;    ///< Distance from the source to each vertex (INF if not reached).
+    vector<int> pred;       ///< Previous vertex on the shortest path to each vertex (-1 if none).
+    vector<int> reached;    ///< Vertices whose labels were set by the last search.
+};
+
+
+/**
+ * @brief Vertices and edges of a CompactGraph that a search must not use.
+ *
+ * This is the equivalent of `Graph::avoidVertices` and `Graph::avoidEdges`, without copying the map.
+ */
+struct SearchMask {
+    vector<char> blockedVertex;     ///< Non-zero for each vertex to avoid (empty if none).
+    vector<char> blockedEdge;       ///< Non-zero for each edge to avoid (empty if none).
+};
+
+
+/**
+ * @brief Options of a search over a CompactGraph.
+ */
+struct SweepOptions {
+    vector<int> targets;                ///< Indexes of the vertices after which the search may stop (all if empty).
+    const SearchMask *mask = nullptr;   ///< Vertices and edges to avoid, if any.
+    double limit = INF;                 ///< Vertices farther than this are not labelled.
+};
+
+
+/**
+ * @brief Builds the mask of a set of restrictions.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param avoidNodes IDs of the locations to avoid.
+ * @param avoidSegs Segments to avoid, as pairs of location IDs (start, end).
+ * @return The mask of the restrictions.
+ */
+template <class T>
+SearchMask makeMask(const CompactGraph<T> &g, const vector<int> &avoidNodes, const vector<pair<int, int>> &avoidSegs) {
+    SearchMask mask;
+
+    if (!avoidNodes.empty()) {
+        mask.blockedVertex.assign(g.getNumVertex(), 0);
+        for (int id : avoidNodes) {
+            int v = g.findIndex(id);
+            if (v != -1) mask.blockedVertex[v] = 1;
+        }
+    }
+
+    if (!avoidSegs.empty()) {
+        mask.blockedEdge.assign(g.getNumEdges(), 0);
+        for (auto &seg : avoidSegs) {
+            int u = g.findIndex(seg.first);
+            int w = g.findIndex(seg.second);
+            if (u == -1 || w == -1) continue;
+            for (int e = g.getFirstEdge(u); e < g.getFirstEdge(u + 1); e++) {
+                if (g.getTarget(e) == w) mask.blockedEdge[e] = 1;
+            }
+        }
+    }
+
+    return mask;
+}
+
+
+/**
+ * @brief Runs Dijkstra's algorithm from a set of sources with initial distances.
+ *
+ * Each seed is a vertex index and its starting distance, which allows chaining searches 
+ * (e.g. walking from every parking node, starting with the time needed to drive there).
+ * The work done is added to the active SearchStats, if any (each push counts as an insert,
+ * since the queue has no decrease-key). The edges of each settled vertex are relaxed with the
+ * fastest kernel the CPU supports (see relax.h).
+ *
+ * @tparam Metric The metric to minimize (see metric.h).
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param seeds Pairs of (vertex index, initial distance).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ */
+template <class Metric, class T>
+void sweepFrom(const CompactGraph<T> &g, const vector<pair<int, double>> &seeds, SearchLabels &labels, const SweepOptions &options = {}) {
+    TRACE_SCOPE("sweep", "search");
+    int n = g.getNumVertex();
+
+    if ((int) labels.dist.size() != n) {
+        labels.dist.assign(n, INF);
+        labels.pred.assign(n, -1);
+    } else {
+        for (int v : labels.reached) {
+            labels.dist[v] = INF;
+            labels.pred[v] = -1;
+        }
+    }
+    labels.reached.clear();
+
+    const SearchMask *mask = options.mask;
+    auto blockedVertex = [&](int v) { return mask && !mask->blockedVertex.empty() && mask->blockedVertex[v]; };
+    auto blockedEdge = [&](int e) { return mask && !mask->blockedEdge.empty() && mask->blockedEdge[e]; };
+
+    vector<int> targets;
+    for (int t : options.targets) {
+        if (t >= 0) targets.push_back(t);
+    }
+    sort(targets.begin(), targets.end());
+    targets.erase(unique(targets.begin(), targets.end()), targets.end());
+    size_t remaining = targets.size();
+
+    typedef pair<double, int> Item;
+    priority_queue<Item, vector<Item>, greater<Item>> pq;
+    unsigned long settled = 0, relaxed = 0, pushes = 0;
+
+    for (auto &seed : seeds) {
+        int v = seed.first;
+        if (v < 0 || v >= n || blockedVertex(v) || seed.second > options.limit) continue;
+        if (seed.second < labels.dist[v]) {
+            if (labels.dist[v] == INF) labels.reached.push_back(v);
+            labels.dist[v] = seed.second;
+            pq.push({seed.second, v});
+            pushes++;
+        }
+    }
+
+    RelaxKernel kernel = relaxKernel();
+    const int *edgeTargets = g.getTargets().data();
+    const double *weights = Metric::weights(g).data();
+    vector<int> improved;
+
+    while (!pq.empty()) {
+        auto [d, v] = pq.top();
+        pq.pop();
+        if (d > labels.dist[v]) continue;     // outdated entry
+        settled++;
+
+        if (remaining && binary_search(targets.begin(), targets.end(), v) && --remaining == 0) break;
+
+        int first = g.getFirstEdge(v), last = g.getFirstEdge(v + 1);
+        if ((int) improved.size() < last - first) improved.resize(last - first);
+        int count = kernel(edgeTargets, weights, first, last, d, labels.dist.data(), options.limit, improved.data());
+        relaxed += last - first;
+
+        for (int i = 0; i < count; i++) {
+            int e = improved[i];
+            int w = edgeTargets[e];
+            if (blockedEdge(e) || blockedVertex(w)) continue;
+
+            // an earlier edge to the same vertex may have improved it already
+            double nd = addWeight(d, (Weight) weights[e]);
+            if (nd < labels.dist[w]) {
+                if (labels.dist[w] == INF) labels.reached.push_back(w);
+                labels.dist[w] = nd;
+                labels.pred[w] = v;
+                pq.push({nd, w});
+                pushes++;
+            }
+        }
+    }
+
+    if (SearchStats *stats = activeStats()) stats->addSearch(settled, relaxed, pushes, 0);
+}
+
+
+/**
+ * @brief Runs Dijkstra's algorithm from a set of sources with initial distances (see `sweepFrom<Metric>`).
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param seeds Pairs of (vertex index, initial distance).
+ * @param mode The mode of transportation (true for driving, false for walking).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ */
+template <class T>
+void sweepFrom(const CompactGraph<T> &g, const vector<pair<int, double>> &seeds, bool mode, SearchLabels &labels, const SweepOptions &options = {}) {
+    if (mode) sweepFrom<DrivingMetric>(g, seeds, labels, options);
+    else sweepFrom<WalkingMetric>(g, seeds, labels, options);
+}
+
+
+/**
+ * @brief Runs Dijkstra's algorithm from a source to every vertex of a CompactGraph.
+ *
+ * When targets are given, the search stops as soon as all of them are settled, so only
+ * their labels (and those of closer vertices) are final.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param source Index of the source vertex.
+ * @param mode The mode of transportation (true for driving, false for walking).
+ * @param labels Labels to fill, resized to the number of vertices.
+ * @param options Targets, restrictions and distance limit of the search.
+ */
+template <class T>
+void sweep(const CompactGraph<T> &g, int source, bool mode, SearchLabels &labels, const SweepOptions &options = {}) {
+    sweepFrom(g, {{source, 0.0}}, mode, labels, options);
+}
+
+
+/**
+ * @brief Retrieves the shortest path to a vertex from the labels of a sweep.
+ *
+ * @tparam T Type of the graph vertices.
+ * @param g The graph.
+ * @param labels The labels computed by `sweep`.
+ * @param target Index of the destination vertex.
+ * @return The location IDs of the path from the source to the target, or an empty vector if unreachable.
+ */
+template <class T>
+vector<int> getSweepPath(const CompactGraph<T> &g, const SearchLabels &labels, int target) {
+    vector<int> res;
+    if (target < 0 || target >= (int) labels.dist.size() || labels.dist[target] == INF) return res;
+
+    for (int v = target; v != -1; v = labels.pred[v]) {
+        res.push_back(g.getId(v));
+    }
+
+    reverse(res.begin(), res.end());
+    return res;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "waypoints.h"
+
+using namespace std;
+
+
+static const double UNREACHABLE = numeric_limits<double>::infinity();
+
+
+double orderCost(const vector<vector<double>> &cost, const vector<int> &order) {
+    int end = cost.size() - 1;
+    double total = 0;
+    int previous = 0;
+
+    for (int w : order) {
+        total += cost[previous][w];
+        previous = w;
+    }
+    return total + cost[previous][end];
+}
+
+
+vector<int> exactWaypointOrder(const vector<vector<double>> &cost) {
+    int k = cost.size() - 2;
+    if (k <= 0) return {};
+
+    // best[set * k + j]: shortest trip from the start through the waypoints in `set`, ending at waypoint j
+    size_t sets = size_t(1) << k;
+    vector<double> best(sets * k, UNREACHABLE);
+    vector<int> previous(sets * k, -1);
+
+    for (int j = 0; j < k; j++) best[(size_t(1) << j) * k + j] = cost[0][j + 1];
+
+    for (size_t set = 1; set < sets; set++) {
+        for (int j = 0; j < k; j++) {
+            if (!(set & (size_t(1) << j))) continue;
+            double d = best[set * k + j];
+            if (d == UNREACHABLE) continue;
+
+            for (int next = 0; next < k; next++) {
+                if (set & (size_t(1) << next)) continue;
+                size_t extended = set | (size_t(1) << next);
+                double nd = d + cost[j + 1][next + 1];
+                if (nd < best[extended * k + next]) {
+                    best[extended * k + next] = nd;
+                    previous[extended * k + next] = j;
+                }
+            }
+        }
+    }
+
+    size_t all = sets - 1;
+    int last = -1;
+    double shortest = UNREACHABLE;
+    for (int j = 0; j < k; j++) {
+        double d = best[all * k + j] + cost[j + 1][k + 1];
+        if (d < shortest) {
+            shortest = d;
+            last = j;
+        }
+    }
+
+    // nothing reaches the end: any order is as good
+    vector<int> order(k);
+    if (last == -1) {
+        iota(order.begin(), order.end(), 1);
+        return order;
+    }
+
+    size_t set = all;
+    for (int i = k - 1; i >= 0; i--) {
+        order[i] = last + 1;
+        int before = previous[set * k + last];
+        set &= ~(size_t(1) << last);
+        last = before;
+    }
+    return order;
+}
+
+
+vector<int> heuristicWaypointOrder(const vector<vector<double>> &cost) {
+    int k = cost.size() - 2;
+    if (k <= 0) return {};
+
+    // nearest waypoint first
+    vector<int> order;
+    vector<bool> visited(k + 1, false);
+    int current = 0;
+
+    for (int step = 0; step < k; step++) {
+        int nearest = -1;
+        for (int w = 1; w <= k; w++) {
+            if (!visited[w] && (nearest == -1 || cost[current][w] < cost[current][nearest])) nearest = w;
+        }
+        visited[nearest] = true;
+        order.push_back(nearest);
+        current = nearest;
+    }
+
+    // reverse parts of the trip while that shortens it (costs may be asymmetric, so the whole trip is measured)
+    double length = orderCost(cost, order);
+    bool improved = true;
+
+    while (improved) {
+        improved = false;
+        for (int i = 0; i < k - 1; i++) {
+            for (int j = i + 1; j < k; j++) {
+                reverse(order.begin() + i, order.begin() + j + 1);
+                double candidate = orderCost(cost, order);
+                if (candidate < length) {
+                    length = candidate;
+                    improved = true;
+                } else {
+                    reverse(order.begin() + i, order.begin() + j + 1);
+                }
+            }
+        }
+    }
+
+    return order;
+}
+
+
+vector<int> bestWaypointOrder(const vector<vector<double>> &cost) {
+    if ((int) cost.size() - 2 <= EXACT_WAYPOINT_LIMIT) return exactWaypointOrder(cost);
+    return heuristicWaypointOrder(cost);
+}
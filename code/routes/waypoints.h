@@ -0,0 +1,66 @@
+/** @file waypoints.h
+ *  @brief Contains functions that choose the order in which waypoints are visited.
+ *
+ *  Given the travel times between a start, some waypoints and an end, these functions find an
+ *  order of the waypoints that makes the trip from the start to the end through all of them as
+ *  short as possible (the path version of the travelling salesman problem). Small sets are solved
+ *  exactly, larger ones with a heuristic.
+ */
+
+#ifndef WAYPOINTS_H
+#define WAYPOINTS_H
+
+#include <vector>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+using namespace std;
+
+
+/**
+ * @brief Largest number of waypoints ordered exactly.
+ *
+ * The exact solver takes O(2^k k^2) time and O(2^k k) memory for k waypoints.
+ */
+const int EXACT_WAYPOINT_LIMIT = 12;
+
+
+/**
+ * @brief Computes the length of a trip through the waypoints in a given order.
+ *
+ * In the cost matrix, index 0 is the start, the last index is the end and the waypoints are in between.
+ *
+ * @param cost Travel time from each stop to each other stop.
+ * @param order Indexes of the waypoints, in the order they are visited.
+ * @return The total travel time from the start to the end.
+ */
+double orderCost(const vector<vector<double>> &cost, const vector<int> &order);
+
+/**
+ * @brief Finds the shortest order of the waypoints with the Held-Karp dynamic program.
+ *
+ * @param cost Travel time from each stop to each other stop (see `orderCost`).
+ * @return Indexes of the waypoints in the best order.
+ */
+vector<int> exactWaypointOrder(const vector<vector<double>> &cost);
+
+/**
+ * @brief Finds a short order of the waypoints, visiting the nearest one first and then
+ * reversing parts of the trip while that makes it shorter (2-opt).
+ *
+ * @param cost Travel time from each stop to each other stop (see `orderCost`).
+ * @return Indexes of the waypoints in the order found.
+ */
+vector<int> heuristicWaypointOrder(const vector<vector<double>> &cost);
+
+/**
+ * @brief Orders the waypoints, exactly if there are at most EXACT_WAYPOINT_LIMIT of them.
+ *
+ * @param cost Travel time from each stop to each other stop (see `orderCost`).
+ * @return Indexes of the waypoints in the order found.
+ */
+vector<int> bestWaypointOrder(const vector<vector<double>> &cost);
+
+
+#endif